@@ -0,0 +1,237 @@
+/*
+ * construction_bench.cpp - automaton construction scaling benchmark ('construction_bench'
+ * target). It features:
+ * - Regex families: each family maps a scale n to one regex, chosen to stress a different
+ * stage - growing keyword unions, the exponential (a|b)*a(a|b)^n family (2^(n+1) DFA states;
+ * the syntax has no {n}, so the repetition is written out), wide overlapping character
+ * classes (canonical input splitting), long string literals and the a?^n a^n optional chain
+ * (epsilon closures).
+ * - Per-stage timing: preprocessRegex, simplifyRegex, insertConcatSymbols,
+ * InfixToPostfix::convert, regexToNFA, buildDFAFromNFA and minimizeDFA are timed separately;
+ * each stage is run 'reps' times on the previous stage's output and the median is reported.
+ * - Scaling curves: one line per (family, n) with the automaton sizes and stage times, plus the
+ * local growth exponent log(t(n) / t(n')) / log(n / n') of the total against the previous row,
+ * so a quadratic regression shows up as an exponent near 2 on a family expected to be linear.
+ * - Budget: a family stops growing once measuring one of its rows (all stages, all 'reps'
+ * repetitions) takes longer than '--budget' seconds of wall time.
+ * - Sizes: nfaNodes counts the distinct nodes the released NFA's edges touch, not the arena's
+ * id range, which also holds nodes merged away by concatenation.
+ *
+ * Usage: construction_bench [--reps N] [--budget SECONDS] [--filter FAMILY]
+ */
+#include "dfa.h"
+#include "regex_parser.h"
+#include "regex_simplifier.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace {
+
+struct Options {
+    int reps = 3;
+    double budgetSeconds = 2.0;
+    std::string filter;
+};
+
+struct Family {
+    std::string name;
+    std::vector<int> scales;
+    std::function<std::string(int n)> regex;
+};
+
+const char kAlnum[] = "0123456789ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz";
+
+std::string keyword(int i) {
+    // 不同长度、共享前缀的关键字，例如 kab、kabc
+    std::string word = "k";
+    for (int v = i + 1; v > 0; v /= 26) word += static_cast<char>('a' + v % 26);
+    return word;
+}
+
+std::vector<Family> makeFamilies() {
+    std::vector<Family> families;
+    families.push_back({"keywords", {8, 16, 32, 64, 128, 256, 512}, [](int n) {
+        std::string re;
+        for (int i = 0; i < n; ++i) re += (i ? "|\"" : "\"") + keyword(i) + "\"";
+        return re;
+    }});
+    families.push_back({"exponential", {2, 4, 6, 8, 10, 12, 14}, [](int n) {
+        std::string re = "(a|b)*a";
+        for (int i = 0; i < n; ++i) re += "(a|b)";
+        return re;
+    }});
+    families.push_back({"classes", {2, 4, 8, 16, 31}, [](int n) {
+        // n 个端点互不相同、彼此重叠的区间，切分出约 2n 个等价类
+        std::string re = "(";
+        for (int i = 0; i < n; ++i) {
+            re += (i ? "|[" : "[") + std::string(1, kAlnum[i]) + "-" + std::string(1, kAlnum[i + 31]) + "]";
+        }
+        return re + ")*";
+    }});
+    families.push_back({"literal", {64, 256, 1024, 4096, 16384}, [](int n) {
+        std::string re = "\"";
+        for (int i = 0; i < n; ++i) re += kAlnum[(i * 7) % 62];
+        return re + "\"";
+    }});
+    families.push_back({"optionals", {8, 16, 32, 64, 128}, [](int n) {
+        std::string re;
+        for (int i = 0; i < n; ++i) re += "a?";
+        for (int i = 0; i < n; ++i) re += "a";
+        return re;
+    }});
+    return families;
+}
+
+const char* const kStages[] = {"preprocess", "simplify", "concat", "postfix", "nfa", "dfa", "minimize"};
+constexpr size_t kNumStages = sizeof(kStages) / sizeof(kStages[0]);
+
+struct Row {
+    double stageSeconds[kNumStages] = {};
+    size_t nfaNodes = 0;          // 边实际连接的不同节点数
+    size_t nfaEdges = 0;
+    size_t dfaStates = 0;
+    size_t minStates = 0;
+
+    double total() const {
+        double sum = 0;
+        for (double s : stageSeconds) sum += s;
+        return sum;
+    }
+};
+
+// 运行 reps 次，返回耗时中位数；每次运行都重新产生输出
+template <typename Fn>
+double timeStage(int reps, Fn&& run) {
+    std::vector<double> seconds;
+    for (int i = 0; i < reps; ++i) {
+        auto start = std::chrono::steady_clock::now();
+        run();
+        seconds.push_back(std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+    }
+    std::sort(seconds.begin(), seconds.end());
+    return seconds[seconds.size() / 2];
+}
+
+Row measure(const std::string& regex, int reps) {
+    Row row;
+    std::vector<Token> tokens, simplified, withConcat, postfix;
+    row.stageSeconds[0] = timeStage(reps, [&] { tokens = preprocessRegex(regex); });
+    row.stageSeconds[1] = timeStage(reps, [&] { simplified = simplifyRegex(tokens); });
+    row.stageSeconds[2] = timeStage(reps, [&] { withConcat = insertConcatSymbols(simplified); });
+    row.stageSeconds[3] = timeStage(reps, [&] {
+        InfixToPostfix converter(withConcat);
+        converter.convert();
+        postfix = converter.getPostfix();
+    });
+
+    NFAUnit nfa;
+    row.stageSeconds[4] = timeStage(reps, [&] {
+        NFAArena arena;
+        NFAFragment fragment = regexToNFA(postfix, arena);
+        nfa = arena.release(fragment.start, fragment.end);
+    });
+    row.nfaEdges = nfa.edges.size();
+    // 节点 ID 来自 arena，连接合并掉的节点也占用 ID：只数边的端点与起止节点
+    std::vector<int> nodes{nfa.start, nfa.end};
+    for (const auto& edge : nfa.edges) {
+        nodes.push_back(edge.startId);
+        nodes.push_back(edge.endId);
+    }
+    std::sort(nodes.begin(), nodes.end());
+    row.nfaNodes = static_cast<size_t>(std::unique(nodes.begin(), nodes.end()) - nodes.begin());
+
+    std::vector<DFAState> dfaStates, minStates;
+    std::vector<DFATransition> dfaTransitions, minTransitions;
+    row.stageSeconds[5] = timeStage(reps, [&] {
+        dfaStates.clear();
+        dfaTransitions.clear();
+        buildDFAFromNFA(nfa, dfaStates, dfaTransitions);
+    });
+    row.stageSeconds[6] = timeStage(reps, [&] {
+        minStates.clear();
+        minTransitions.clear();
+        minimizeDFA(dfaStates, dfaTransitions, nfa.end, minStates, minTransitions);
+    });
+    row.dfaStates = dfaStates.size();
+    row.minStates = minStates.size();
+    return row;
+}
+
+bool parseOptions(int argc, char* argv[], Options& options) {
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (i + 1 >= argc) return false;
+        try {
+            if (arg == "--reps") {
+                options.reps = std::max(1, std::stoi(argv[++i]));
+            } else if (arg == "--budget") {
+                options.budgetSeconds = std::stod(argv[++i]);
+            } else if (arg == "--filter") {
+                options.filter = argv[++i];
+            } else {
+                return false;
+            }
+        } catch (...) {
+            return false;
+        }
+    }
+    return true;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    Options options;
+    if (!parseOptions(argc, argv, options)) {
+        std::fprintf(stderr, "Usage: construction_bench [--reps N] [--budget SECONDS] [--filter FAMILY]\n");
+        return 2;
+    }
+
+    std::printf("# construction_bench v1 reps=%d budget=%.1fs (stage times in microseconds)\n",
+                options.reps, options.budgetSeconds);
+    std::printf("# %-11s %6s %7s %8s %8s %8s %8s", "family", "n", "length", "nfaNodes", "nfaEdges",
+                "dfa", "minDfa");
+    for (const char* stage : kStages) std::printf(" %11s", stage);
+    std::printf(" %12s %6s\n", "total", "exp");
+
+    try {
+        for (const auto& family : makeFamilies()) {
+            if (!options.filter.empty() && family.name.find(options.filter) == std::string::npos) continue;
+
+            int previousScale = 0;
+            double previousTotal = 0;
+            for (int n : family.scales) {
+                const std::string regex = family.regex(n);
+                const auto rowStart = std::chrono::steady_clock::now();
+                Row row = measure(regex, options.reps);
+                const double rowSeconds =
+                    std::chrono::duration<double>(std::chrono::steady_clock::now() - rowStart).count();
+
+                std::printf("  %-11s %6d %7zu %8zu %8zu %8zu %8zu", family.name.c_str(), n, regex.size(),
+                            row.nfaNodes, row.nfaEdges, row.dfaStates, row.minStates);
+                for (double s : row.stageSeconds) std::printf(" %11.1f", s * 1e6);
+                const double total = row.total();
+                std::printf(" %12.1f", total * 1e6);
+                if (previousScale > 0 && previousTotal > 0 && total > 0) {
+                    std::printf(" %6.2f\n", std::log(total / previousTotal) / std::log(double(n) / previousScale));
+                } else {
+                    std::printf(" %6s\n", "-");
+                }
+                std::fflush(stdout);
+
+                previousScale = n;
+                previousTotal = total;
+                if (rowSeconds > options.budgetSeconds) break;
+            }
+        }
+    } catch (const std::exception& e) {
+        std::fprintf(stderr, "[Error]: %s\n", e.what());
+        return 1;
+    }
+    return 0;
+}
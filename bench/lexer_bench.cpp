@@ -0,0 +1,414 @@
+/*
+ * lexer_bench.cpp - tokenizer throughput benchmark ('lexer_bench' target). It features:
+ * - Corpora: the inputs of tests/lexer_cases that lex cleanly, concatenated and repeated up to
+ * the corpus size, plus synthetic lang.l sources (identifier-heavy, numeric, operator-dense,
+ * whitespace-heavy and a mixed program) generated from a fixed seed, so every run and every
+ * commit measures the same bytes.
+ * - Scanners: every front-end over the lang.l lexer - Lexer::tokenize, tokenizeSpans into a
+ * reused buffer, tokenizeSpansClassified, the forEachToken visitor, TokenReader,
+ * tokenizeSpansParallel and the compile-time StaticLexer - plus tokenizeSpans and
+ * tokenizeSpansClassified at each SIMD level the CPU supports (spans-none is the plain table
+ * loop), so the pre-classified mode is compared with the scalar path in the same run.
+ * - Two tables: Lexer::createDefault() uses the unminimized compile-time DFA; the same scanners
+ * prefixed 'built-' run on a Lexer whose lang.l rules went through build(), the minimized
+ * table every other user of the library gets.
+ * - Cross-check: one untimed run per (corpus, scanner) folds every emitted token's (offset,
+ * length, class) into a hash; all scanners must agree on it or the run fails.
+ * - The header line records each table's rows, byte class count and classifier shuffle rows,
+ * the numbers the classified-versus-scalar result depends on.
+ * - Measurement: 'warmup' untimed runs, then 'reps' timed runs per (corpus, scanner); reports the
+ * median throughput in MB/s and Mtokens/s, ns/byte, the relative standard deviation over the
+ * repetitions and heap allocations per run (global operator new is counted in this binary).
+ * - Stable output: one whitespace-separated line per (corpus, scanner) in a fixed column order
+ * under a '#' header, so runs of two commits can be diffed or joined column by column.
+ *
+ * Usage: lexer_bench [--reps N] [--warmup N] [--size MB] [--filter TEXT] [--cases DIR]
+ */
+#include "lang_lexer.h"
+#include "lexer.h"
+#include "token_reader.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <deque>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <new>
+#include <random>
+#include <string>
+#include <vector>
+
+#ifndef LEXER_BENCH_CASES_DIR
+#define LEXER_BENCH_CASES_DIR "tests/lexer_cases"
+#endif
+
+// 统计本进程的堆分配次数
+static std::atomic<size_t> g_allocations{0};
+
+void* operator new(size_t size) {
+    g_allocations.fetch_add(1, std::memory_order_relaxed);
+    if (void* p = std::malloc(size ? size : 1)) return p;
+    throw std::bad_alloc();
+}
+void* operator new[](size_t size) { return operator new(size); }
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete[](void* p) noexcept { std::free(p); }
+void operator delete(void* p, size_t) noexcept { std::free(p); }
+void operator delete[](void* p, size_t) noexcept { std::free(p); }
+
+namespace {
+
+struct Options {
+    int reps = 10;
+    int warmup = 2;
+    size_t corpusBytes = 8u << 20;
+    std::string filter;                  // 只运行名称（corpus/scanner）包含该子串的组合
+    std::string casesDir = LEXER_BENCH_CASES_DIR;
+};
+
+struct Corpus {
+    std::string name;
+    std::string text;
+};
+
+// 交叉校验用的 token 流摘要：按顺序折叠每个 emit 的 token 的 (offset, length, class)
+struct Digest {
+    size_t tokens = 0;
+    uint64_t hash = 14695981039346656037ull;
+
+    void add(uint64_t offset, uint64_t length, int tokenClassId) {
+        for (uint64_t value : {offset, length, static_cast<uint64_t>(static_cast<uint32_t>(tokenClassId))}) {
+            hash = (hash ^ value) * 1099511628211ull;
+        }
+        ++tokens;
+    }
+    bool operator!=(const Digest& other) const { return tokens != other.tokens || hash != other.hash; }
+};
+
+void digestSpans(const std::vector<TokenSpan>& spans, Digest* digest) {
+    if (!digest) return;
+    for (const TokenSpan& span : spans) digest->add(span.offset, span.length, span.tokenClassId);
+}
+
+// 返回 emit 的 token 数；digest 非空时（只在不计时的校验运行中）同时记录摘要
+using ScanFn = std::function<size_t(const std::string& input, Digest* digest)>;
+
+struct Scanner {
+    std::string name;
+    ScanFn scan;
+};
+
+// tests/lexer_cases 中可以被正确分析的输入（">>> " 行），拼接并重复到 size 字节
+Corpus loadCaseCorpus(const Lexer& lexer, const std::string& directory, size_t size) {
+    std::vector<std::string> files;
+    for (const auto& entry : std::filesystem::directory_iterator(directory)) {
+        if (entry.path().extension() == ".txt") files.push_back(entry.path().string());
+    }
+    std::sort(files.begin(), files.end());
+
+    std::string cases;
+    std::vector<TokenSpan> spans;
+    for (const auto& file : files) {
+        std::ifstream in(file);
+        std::string line;
+        while (std::getline(in, line)) {
+            if (line.rfind(">>> ", 0) != 0) continue;
+            try {
+                lexer.tokenizeSpans(line.substr(4), spans);
+            } catch (const std::exception&) {
+                continue;                // 错误用例不计入吞吐
+            }
+            cases += line.substr(4);
+            cases += '\n';
+        }
+    }
+
+    Corpus corpus{"lexer_cases", ""};
+    while (!cases.empty() && corpus.text.size() < size) corpus.text += cases;
+    return corpus;
+}
+
+// 由固定种子生成的 lang.l 源码，piece() 产生一段（含分隔符）
+Corpus generateCorpus(const std::string& name, size_t size, const std::function<std::string(std::mt19937&)>& piece) {
+    std::mt19937 rng(20240601);
+    Corpus corpus{name, ""};
+    corpus.text.reserve(size + 256);
+    while (corpus.text.size() < size) corpus.text += piece(rng);
+    return corpus;
+}
+
+std::string identifier(std::mt19937& rng, size_t minLength, size_t maxLength) {
+    static const char first[] = "_abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ";
+    static const char rest[] = "_abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789";
+    size_t length = minLength + rng() % (maxLength - minLength + 1);
+    std::string id(1, first[rng() % (sizeof(first) - 1)]);
+    while (id.size() < length) id += rest[rng() % (sizeof(rest) - 1)];
+    return id;
+}
+
+std::string number(std::mt19937& rng) {
+    std::string digits = std::to_string(rng() % 100000);
+    switch (rng() % 4) {
+        case 0:  return digits;
+        case 1:  return digits + "." + std::to_string(rng() % 1000);
+        case 2:  return digits + "e" + std::to_string(rng() % 40);
+        default: return "." + std::to_string(rng() % 1000) + "E-" + std::to_string(rng() % 9);
+    }
+}
+
+std::vector<Corpus> makeCorpora(const Lexer& lexer, const Options& options) {
+    static const char* const ops[] = {"+", "-", "*", "/", "%", "<", ">", "=", "!", "&", ",", ";",
+                                      "<=", ">=", "==", "!=", "&&", "||", "+=", "-=", "*=", "/=",
+                                      "(", ")", "{", "}"};
+    const size_t size = options.corpusBytes;
+    std::vector<Corpus> corpora;
+    corpora.push_back(loadCaseCorpus(lexer, options.casesDir, size));
+    corpora.push_back(generateCorpus("identifiers", size, [](std::mt19937& rng) {
+        return identifier(rng, 3, 24) + (rng() % 8 == 0 ? "\n" : " ");
+    }));
+    corpora.push_back(generateCorpus("numbers", size, [](std::mt19937& rng) {
+        return number(rng) + (rng() % 8 == 0 ? "\n" : " ");
+    }));
+    corpora.push_back(generateCorpus("operators", size, [](std::mt19937& rng) {
+        // 运算符之间只插入单字符标识符，几乎每个字节都是 token 边界
+        std::string s = ops[rng() % (sizeof(ops) / sizeof(ops[0]))];
+        s += static_cast<char>('a' + rng() % 26);
+        return s;
+    }));
+    corpora.push_back(generateCorpus("whitespace", size, [](std::mt19937& rng) {
+        return std::string(1 + rng() % 30, " \t\r\n"[rng() % 4]) + identifier(rng, 1, 4);
+    }));
+    corpora.push_back(generateCorpus("program", size, [](std::mt19937& rng) {
+        std::string a = identifier(rng, 1, 10), b = identifier(rng, 1, 10);
+        switch (rng() % 5) {
+            case 0:  return "var " + a + " = " + number(rng) + ";\n";
+            case 1:  return "if (" + a + " <= " + b + ") then { " + a + " += 1; }\n";
+            case 2:  return "while (" + a + " != " + number(rng) + " && " + b + ") do { " + b + " = " + b + " * 2; }\n";
+            case 3:  return "func " + a + "(" + b + ", " + identifier(rng, 1, 6) + ") { return " + b + " % 7; }\n";
+            default: return "    " + a + " = " + b + " - " + number(rng) + " / (" + a + " + 1);\n";
+        }
+    }));
+    return corpora;
+}
+
+// prefix 加在扫描器名称前；withStatic 为真时加入编译期 StaticLexer（它只对应默认表）
+void addScanners(std::vector<Scanner>& scanners, const Lexer& lexer, const std::string& prefix, bool withStatic,
+                 std::deque<Lexer>& variants) {
+    auto add = [&](const std::string& name, ScanFn scan) { scanners.push_back({prefix + name, std::move(scan)}); };
+    add("tokenize", [&lexer, lineStarts = std::vector<size_t>()](const std::string& input, Digest* digest) mutable {
+        std::vector<LexerToken> tokens = lexer.tokenize(input);
+        if (digest) {
+            // LexerToken 只有行列号：换算回字节偏移（列号按字节计）
+            lineStarts.assign(1, 0);
+            for (size_t i = 0; i < input.size(); ++i) {
+                if (input[i] == '\n') lineStarts.push_back(i + 1);
+            }
+            for (const LexerToken& token : tokens) {
+                digest->add(lineStarts[token.line - 1] + token.column - 1, token.lexeme.size(), token.tokenClassId);
+            }
+        }
+        return tokens.size();
+    });
+    add("spans", [&lexer, spans = std::vector<TokenSpan>()](const std::string& input, Digest* digest) mutable {
+        lexer.tokenizeSpans(input, spans);
+        digestSpans(spans, digest);
+        return spans.size();
+    });
+    // 同一张表在不同 SIMD 级别下的对比（spans / classified 为默认设置：不做自环加速，分类器用
+    // CPU 支持的最高级别）：spans-* 开启自环加速，classified-* 为预分类模式，classified-none 用标量分类
+    const std::pair<SimdLevel, const char*> levels[] = {
+        {SimdLevel::None, "none"}, {SimdLevel::SSE2, "sse2"}, {SimdLevel::AVX2, "avx2"}};
+    for (const auto& [level, suffix] : levels) {
+        if (level != SimdLevel::None && static_cast<int>(level) > static_cast<int>(detectSimdLevel())) continue;
+        variants.push_back(lexer);
+        variants.back().setSimdLevel(level);
+        const Lexer& variant = variants.back();
+        if (level == SimdLevel::None || variant.getTable().selfLoops) {
+            add(std::string("spans-") + suffix,
+                [&variant, spans = std::vector<TokenSpan>()](const std::string& input, Digest* digest) mutable {
+                variant.tokenizeSpans(input, spans);
+                digestSpans(spans, digest);
+                return spans.size();
+            });
+        }
+        if (variant.getTable().classifier->level == level) {
+            add(std::string("classified-") + suffix,
+                [&variant, spans = std::vector<TokenSpan>()](const std::string& input, Digest* digest) mutable {
+                variant.tokenizeSpansClassified(input, spans);
+                digestSpans(spans, digest);
+                return spans.size();
+            });
+        }
+    }
+    add("classified", [&lexer, spans = std::vector<TokenSpan>()](const std::string& input, Digest* digest) mutable {
+        lexer.tokenizeSpansClassified(input, spans);
+        digestSpans(spans, digest);
+        return spans.size();
+    });
+    add("visitor", [&lexer](const std::string& input, Digest* digest) {
+        size_t count = 0;
+        if (digest) {
+            lexer.forEachToken(input, [digest](const TokenSpan& span) { digest->add(span.offset, span.length, span.tokenClassId); });
+            return digest->tokens;
+        }
+        lexer.forEachToken(input, [&count](const TokenSpan&) { ++count; });
+        return count;
+    });
+    add("reader", [&lexer](const std::string& input, Digest* digest) {
+        TokenReader reader(lexer, input);
+        TokenView token;
+        size_t count = 0;
+        while (reader.next(token)) {
+            ++count;
+            if (digest) digest->add(token.offset, token.lexeme.size(), token.tokenClassId);
+        }
+        return count;
+    });
+    add("parallel", [&lexer, spans = std::vector<TokenSpan>()](const std::string& input, Digest* digest) mutable {
+        lexer.tokenizeSpansParallel(input, spans);
+        digestSpans(spans, digest);
+        return spans.size();
+    });
+    if (withStatic) {
+        add("static", [](const std::string& input, Digest* digest) {
+            size_t count = 0;
+            size_t stop = digest ? kLangLexer.forEachToken(input, [digest](size_t offset, size_t length, int tokenClass) {
+                                       digest->add(offset, length, tokenClass);
+                                   })
+                                 : kLangLexer.forEachToken(input, [&count](size_t, size_t, int) { ++count; });
+            if (stop != input.size()) throw std::runtime_error("static lexer stopped at offset " + std::to_string(stop));
+            return digest ? digest->tokens : count;
+        });
+    }
+}
+
+struct Result {
+    size_t tokens = 0;
+    Digest digest;
+    double medianSeconds = 0;
+    double relativeStddev = 0;           // 各次耗时的标准差 / 平均值
+    double allocationsPerRun = 0;
+};
+
+Result measure(const Scanner& scanner, const std::string& input, const Options& options) {
+    Result result;
+    scanner.scan(input, &result.digest);
+    for (int i = 0; i < options.warmup; ++i) result.tokens = scanner.scan(input, nullptr);
+
+    std::vector<double> seconds;
+    size_t allocations = 0;
+    for (int i = 0; i < options.reps; ++i) {
+        size_t before = g_allocations.load(std::memory_order_relaxed);
+        auto start = std::chrono::steady_clock::now();
+        result.tokens = scanner.scan(input, nullptr);
+        auto stop = std::chrono::steady_clock::now();
+        allocations += g_allocations.load(std::memory_order_relaxed) - before;
+        seconds.push_back(std::chrono::duration<double>(stop - start).count());
+    }
+
+    double mean = 0;
+    for (double s : seconds) mean += s;
+    mean /= seconds.size();
+    double variance = 0;
+    for (double s : seconds) variance += (s - mean) * (s - mean);
+    variance /= seconds.size();
+    std::sort(seconds.begin(), seconds.end());
+    result.medianSeconds = seconds[seconds.size() / 2];
+    result.relativeStddev = mean > 0 ? std::sqrt(variance) / mean : 0;
+    result.allocationsPerRun = static_cast<double>(allocations) / options.reps;
+    return result;
+}
+
+bool parseOptions(int argc, char* argv[], Options& options) {
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (i + 1 >= argc) return false;
+        try {
+            if (arg == "--reps") {
+                options.reps = std::max(1, std::stoi(argv[++i]));
+            } else if (arg == "--warmup") {
+                options.warmup = std::max(0, std::stoi(argv[++i]));
+            } else if (arg == "--size") {
+                options.corpusBytes = static_cast<size_t>(std::max(1, std::stoi(argv[++i]))) << 20;
+            } else if (arg == "--filter") {
+                options.filter = argv[++i];
+            } else if (arg == "--cases") {
+                options.casesDir = argv[++i];
+            } else {
+                return false;
+            }
+        } catch (...) {
+            return false;
+        }
+    }
+    return true;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    Options options;
+    if (!parseOptions(argc, argv, options)) {
+        std::fprintf(stderr, "Usage: lexer_bench [--reps N] [--warmup N] [--size MB] [--filter TEXT] [--cases DIR]\n");
+        return 2;
+    }
+
+    try {
+        Lexer lexer = Lexer::createDefault();
+        Lexer built;
+        built.initializeDefaultTokenClasses();
+        built.build();
+        std::vector<Corpus> corpora = makeCorpora(lexer, options);
+        std::deque<Lexer> variants;
+        std::vector<Scanner> scanners;
+        addScanners(scanners, lexer, "", true, variants);
+        addScanners(scanners, built, "built-", false, variants);
+
+        const LexerTable& table = lexer.getTable();
+        const LexerTable& builtTable = built.getTable();
+        std::printf("# lexer_bench v1 reps=%d warmup=%d rows=%d classes=%d classifierRows=%d "
+                    "built-rows=%d built-classes=%d built-classifierRows=%d\n",
+                    options.reps, options.warmup, table.numRows, table.numClasses, table.classifier->numRows,
+                    builtTable.numRows, builtTable.numClasses, builtTable.classifier->numRows);
+        std::printf("# %-12s %-22s %10s %9s %9s %10s %8s %7s %12s\n", "corpus", "scanner", "bytes",
+                    "tokens", "MB/s", "Mtokens/s", "ns/byte", "rsd%", "allocs/run");
+        int status = 0;
+        for (const auto& corpus : corpora) {
+            Digest expected;
+            std::string expectedFrom;
+            for (const auto& scanner : scanners) {
+                if (!options.filter.empty() &&
+                    (corpus.name + "/" + scanner.name).find(options.filter) == std::string::npos) {
+                    continue;
+                }
+                Result r = measure(scanner, corpus.text, options);
+                if (!expectedFrom.empty() && (r.digest != expected || r.tokens != expected.tokens)) {
+                    std::fprintf(stderr, "%s/%s: %zu tokens (hash %016llx), %s: %zu tokens (hash %016llx)\n",
+                                 corpus.name.c_str(), scanner.name.c_str(), r.digest.tokens,
+                                 static_cast<unsigned long long>(r.digest.hash), expectedFrom.c_str(),
+                                 expected.tokens, static_cast<unsigned long long>(expected.hash));
+                    status = 1;
+                }
+                if (expectedFrom.empty()) {
+                    expected = r.digest;
+                    expectedFrom = scanner.name;
+                }
+
+                const double bytes = static_cast<double>(corpus.text.size());
+                std::printf("  %-12s %-22s %10zu %9zu %9.1f %10.2f %8.3f %7.2f %12.1f\n",
+                            corpus.name.c_str(), scanner.name.c_str(), corpus.text.size(), r.tokens,
+                            bytes / r.medianSeconds / 1e6, r.tokens / r.medianSeconds / 1e6,
+                            r.medianSeconds * 1e9 / bytes, r.relativeStddev * 100, r.allocationsPerRun);
+                std::fflush(stdout);
+            }
+        }
+        return status;
+    } catch (const std::exception& e) {
+        std::fprintf(stderr, "[Error]: %s\n", e.what());
+        return 1;
+    }
+}
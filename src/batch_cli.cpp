@@ -0,0 +1,414 @@
+/*
+ * batch_cli.cpp - implements the 'lex' batch command. It features:
+ * - Argument parsing: '--rules FILE' selects a rules file ("NAME REGEX" per line, '#'
+ * comments); without it the predefined lang.l token classes are used. '--lexer FILE' instead
+ * memory-maps a lexer image written by the 'compile' command, skipping construction entirely.
+ * '--input' takes one or more files, '-' meaning standard input.
+ * - compile: builds the lexer from the same rule options and saves its binary image
+ * (lexer_image.h) with '--output FILE'; '--stats' prints the BuildStats of the build.
+ * - gen: writes a standalone C++ scanner for the rules or a compiled lexer
+ * (scanner_generator.h), table-driven or direct-coded ('--style').
+ * - Build cache: '--cache DIR' (default: the REGEX_AUTOMATA_CACHE environment variable) lets a
+ * rules-file build reuse the image of an earlier build of the same rules (lexer_cache.h).
+ * - One build, many inputs: the lexer is built once; no build log sink is installed, so
+ * stdout carries nothing but token records. The default lang.l lexer is not built at all: its
+ * tables are produced at compile time (lang_lexer.h).
+ * - Zero-copy input: files are memory-mapped (MappedFile) and tokenized in one pass with
+ * 'tokenizeSpans'; standard input goes through StreamLexer in bounded memory.
+ * - Machine-readable output: one record per token, "file<TAB>line<TAB>column<TAB>class<TAB>lexeme",
+ * with backslash, tab, newline and carriage return in the lexeme escaped as \\, \t, \n and \r.
+ * Records of the file whose turn it is are written in 1 MiB batches; later files buffer theirs
+ * until the earlier ones are done. Standard input is not read before its turn (at most one '-').
+ * - Errors: a lexical error is reported on stderr as "file: message", the remaining inputs are
+ * still processed, and the exit code is 1.
+ * - Parallelism: '--jobs N' (default: all cores) tokenizes files on a work-stealing pool that
+ * shares the one built, read-only Lexer. Each worker keeps its own span buffer; per-file
+ * results are committed in command-line order, so output is identical for any N. A single
+ * input is instead split into chunks and lexed speculatively in parallel (parallel_lexer.cpp).
+ */
+#include "batch_cli.h"
+#include "lexer.h"
+#include "mapped_file.h"
+#include "scanner_generator.h"
+#include "stream_lexer.h"
+#include "work_stealing.h"
+#include <algorithm>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace {
+
+struct LexOptions {
+    std::string rulesFile;              // 为空时使用预定义的 lang.l 规则
+    std::string lexerFile;              // 非空时直接读入已编译的映像
+    std::string cacheDirectory;         // 为空时不使用构建缓存
+    std::vector<std::string> inputs;
+    unsigned jobs = 0;                  // 0 表示使用全部核心
+};
+
+void printLexUsage() {
+    std::cerr << "Usage: regex_automata lex [--rules FILE | --lexer FILE] [--cache DIR] [--jobs N] --input FILE...\n"
+              << "  --rules FILE   token rules, one 'NAME REGEX' per line (default: lang.l tokens)\n"
+              << "  --lexer FILE   compiled lexer written by 'regex_automata compile'\n"
+              << "  --cache DIR    build cache directory (default: $REGEX_AUTOMATA_CACHE)\n"
+              << "  --jobs N       worker threads (default: number of cores)\n"
+              << "  --input FILE   files to tokenize ('-' reads standard input, at most once)\n"
+              << "Output: file<TAB>line<TAB>column<TAB>class<TAB>lexeme, one token per line\n";
+}
+
+// 默认的构建缓存目录：环境变量 REGEX_AUTOMATA_CACHE，未设置时不使用缓存
+std::string defaultCacheDirectory() {
+    const char* directory = std::getenv("REGEX_AUTOMATA_CACHE");
+    return directory ? directory : "";
+}
+
+bool parseLexOptions(int argc, char* argv[], LexOptions& options) {
+    options.cacheDirectory = defaultCacheDirectory();
+    for (int i = 0; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--rules") {
+            if (i + 1 >= argc) return false;
+            options.rulesFile = argv[++i];
+        } else if (arg == "--lexer") {
+            if (i + 1 >= argc) return false;
+            options.lexerFile = argv[++i];
+        } else if (arg == "--cache") {
+            if (i + 1 >= argc) return false;
+            options.cacheDirectory = argv[++i];
+        } else if (arg == "--jobs") {
+            if (i + 1 >= argc) return false;
+            try {
+                int jobs = std::stoi(argv[++i]);
+                if (jobs < 1) return false;
+                options.jobs = static_cast<unsigned>(jobs);
+            } catch (...) {
+                return false;
+            }
+        } else if (arg == "--input") {
+            // --input 之后直到下一个选项的所有参数都是输入文件
+            while (i + 1 < argc && std::string(argv[i + 1]).rfind("--", 0) != 0) {
+                options.inputs.push_back(argv[++i]);
+            }
+            // 标准输入只能读一次；读它的任务会等待轮到自己输出，多个 '-' 可能占满全部工作线程
+            if (std::count(options.inputs.begin(), options.inputs.end(), "-") > 1) return false;
+        } else {
+            return false;
+        }
+    }
+    return !options.inputs.empty() && (options.rulesFile.empty() || options.lexerFile.empty());
+}
+
+void appendEscaped(std::string& out, std::string_view text) {
+    for (char c : text) {
+        switch (c) {
+            case '\\': out += "\\\\"; break;
+            case '\t': out += "\\t"; break;
+            case '\n': out += "\\n"; break;
+            case '\r': out += "\\r"; break;
+            default:   out += c; break;
+        }
+    }
+}
+
+void appendRecord(std::string& out, const std::string& file, int line, int column,
+                  const std::string& className, std::string_view lexeme) {
+    out += file;
+    out += '\t';
+    out += std::to_string(line);
+    out += '\t';
+    out += std::to_string(column);
+    out += '\t';
+    out += className;
+    out += '\t';
+    appendEscaped(out, lexeme);
+    out += '\n';
+}
+
+/**
+ * 按输入顺序提交各文件的结果：文件 i 只有在 0 .. i-1 都写出之后才会写出，
+ * 因此输出与线程数和调度顺序无关
+ */
+class OrderedOutput {
+public:
+    explicit OrderedOutput(size_t numFiles) : results_(numFiles) {}
+
+    // 阻塞到文件 index 成为下一个待写出的文件（之前的文件都已 finish）
+    void waitForTurn(size_t index) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        turn_.wait(lock, [&] { return next_ == index; });
+    }
+
+    // 文件 index 的部分记录：若它已是下一个待写出的文件则直接写出并清空 out，否则留待 finish
+    void writePartial(size_t index, std::string& out) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (index == next_) {
+            std::fwrite(out.data(), 1, out.size(), stdout);
+            out.clear();
+        }
+    }
+
+    void finish(size_t index, std::string out, std::string error) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        results_[index] = {std::move(out), std::move(error), true};
+        for (; next_ < results_.size() && results_[next_].done; ++next_) {
+            FileResult& result = results_[next_];
+            std::fwrite(result.records.data(), 1, result.records.size(), stdout);
+            if (!result.error.empty()) {
+                std::fflush(stdout);
+                std::cerr << result.error << "\n";
+            }
+            result = FileResult{{}, {}, true};   // 释放已写出的缓冲区
+        }
+        turn_.notify_all();
+    }
+
+private:
+    struct FileResult {
+        std::string records;
+        std::string error;
+        bool done = false;
+    };
+
+    std::mutex mutex_;
+    std::condition_variable turn_;
+    std::vector<FileResult> results_;
+    size_t next_ = 0;
+};
+
+// 轮到输出的文件每积累这么多字节的记录就写出一次
+constexpr size_t kFlushThreshold = 1 << 20;
+
+// 映射整个文件并一次性分析；spans 在各文件间复用。threads > 1 时对文件内部做并行分析。
+// 记录在分析成功之后才生成，轮到该文件输出时按 kFlushThreshold 分批写出
+void lexMappedFile(const Lexer& lexer, const std::string& file, unsigned threads, size_t index,
+                   OrderedOutput& output, std::vector<TokenSpan>& spans, std::string& out) {
+    MappedFile mapped(file);
+    std::string_view input = mapped.data();
+    if (threads > 1) {
+        lexer.tokenizeSpansParallel(input, spans, threads);
+    } else {
+        lexer.tokenizeSpans(input, spans);
+    }
+
+    // 行列号随 token 顺序增量推进
+    size_t pos = 0;
+    int line = 1, column = 1;
+    for (const TokenSpan& span : spans) {
+        for (; pos < span.offset; ++pos) {
+            if (input[pos] == '\n') {
+                line++;
+                column = 1;
+            } else {
+                column++;
+            }
+        }
+        appendRecord(out, file, line, column, lexer.getTokenClassName(span.tokenClassId),
+                     Lexer::lexemeOf(input, span));
+        if (out.size() >= kFlushThreshold) output.writePartial(index, out);
+    }
+}
+
+// 标准输入可能是管道且没有上限：等到轮到它输出时才开始读，记录按 kFlushThreshold 分批写出，
+// 因此缓冲的记录不超过一批
+void lexStandardInput(const Lexer& lexer, const std::string& file, size_t index,
+                      OrderedOutput& output, std::string& out) {
+    output.waitForTurn(index);
+    StreamLexer stream = StreamLexer::fromFileDescriptor(lexer, 0);
+    TokenView token;
+    while (stream.next(token)) {
+        appendRecord(out, file, token.line, token.column,
+                     lexer.getTokenClassName(token.tokenClassId), token.lexeme);
+        if (out.size() >= kFlushThreshold) output.writePartial(index, out);
+    }
+}
+
+// 按规则文件构建（cacheDirectory 非空时经构建缓存）；未指定时直接使用编译期构建的 lang.l lexer，
+// 此时统计中只有转移表相关的字段。measureMemory 为真时测量峰值内存（会重置进程的高水位）
+BuildStats buildLexer(const std::string& rulesFile, const std::string& cacheDirectory, Lexer& lexer,
+                      bool measureMemory = false) {
+    if (rulesFile.empty()) {
+        const PeakMemoryMeter memory(measureMemory);
+        lexer = Lexer::createDefault();
+        const LexerTable& table = lexer.getTable();
+        BuildStats stats;
+        stats.tokenClasses = lexer.getTokenClasses().size();
+        stats.byteClasses = static_cast<size_t>(table.numClasses);
+        stats.stateIdBytes = static_cast<size_t>(table.width);
+        stats.imageBytes = table.imageSize;
+        stats.peakMemoryBytes = memory.peakBytes();
+        return stats;
+    }
+    lexer.loadTokenClassesFromFile(rulesFile);
+    lexer.setCacheDirectory(cacheDirectory);
+    lexer.setMeasurePeakMemory(measureMemory);
+    return lexer.build();
+}
+
+} // namespace
+
+int runCompileCommand(int argc, char* argv[]) {
+    std::string rulesFile;
+    std::string cacheDirectory = defaultCacheDirectory();
+    std::string outputFile;
+    bool printStats = false;
+    bool valid = true;
+    for (int i = 0; i < argc && valid; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--rules" && i + 1 < argc) {
+            rulesFile = argv[++i];
+        } else if (arg == "--cache" && i + 1 < argc) {
+            cacheDirectory = argv[++i];
+        } else if (arg == "--output" && i + 1 < argc) {
+            outputFile = argv[++i];
+        } else if (arg == "--stats") {
+            printStats = true;
+        } else {
+            valid = false;
+        }
+    }
+    if (!valid || outputFile.empty()) {
+        std::cerr << "Usage: regex_automata compile [--rules FILE] [--cache DIR] [--stats] --output FILE\n"
+                  << "  --rules FILE    token rules, one 'NAME REGEX' per line (default: lang.l tokens)\n"
+                  << "  --cache DIR     build cache directory (default: $REGEX_AUTOMATA_CACHE)\n"
+                  << "  --stats         print build statistics to stdout, one 'name value' per line\n"
+                  << "  --output FILE   where to write the compiled lexer (load with 'lex --lexer FILE')\n";
+        return 2;
+    }
+
+    try {
+        Lexer lexer;
+        BuildStats stats = buildLexer(rulesFile, cacheDirectory, lexer, printStats);
+        lexer.save(outputFile);
+        if (printStats) writeBuildStats(stats, std::cout);
+    } catch (const std::exception& e) {
+        std::cerr << "[Error]: " << e.what() << "\n";
+        return 1;
+    }
+    return 0;
+}
+
+int runGenCommand(int argc, char* argv[]) {
+    std::string rulesFile;
+    std::string lexerFile;
+    std::string cacheDirectory = defaultCacheDirectory();
+    std::string outputFile;
+    ScannerOptions options;
+    bool valid = true;
+    for (int i = 0; i < argc && valid; ++i) {
+        std::string arg = argv[i];
+        if (i + 1 >= argc) {
+            valid = false;
+        } else if (arg == "--rules") {
+            rulesFile = argv[++i];
+        } else if (arg == "--lexer") {
+            lexerFile = argv[++i];
+        } else if (arg == "--cache") {
+            cacheDirectory = argv[++i];
+        } else if (arg == "--output") {
+            outputFile = argv[++i];
+        } else if (arg == "--namespace") {
+            options.namespaceName = argv[++i];
+        } else if (arg == "--style") {
+            std::string style = argv[++i];
+            if (style == "table") {
+                options.style = ScannerStyle::Table;
+            } else if (style == "direct") {
+                options.style = ScannerStyle::DirectCoded;
+            } else {
+                valid = false;
+            }
+        } else {
+            valid = false;
+        }
+    }
+    if (!valid || outputFile.empty() || (!rulesFile.empty() && !lexerFile.empty())) {
+        std::cerr << "Usage: regex_automata gen [--rules FILE | --lexer FILE] [--cache DIR]\n"
+                  << "                          [--style direct|table] [--namespace NAME] --output FILE\n"
+                  << "  --rules FILE       token rules, one 'NAME REGEX' per line (default: lang.l tokens)\n"
+                  << "  --lexer FILE       compiled lexer written by 'regex_automata compile'\n"
+                  << "  --cache DIR        build cache directory (default: $REGEX_AUTOMATA_CACHE)\n"
+                  << "  --style STYLE      'direct' (goto per state, default) or 'table' (static tables)\n"
+                  << "  --namespace NAME   namespace of the generated code (default: generated_lexer)\n"
+                  << "  --output FILE      generated C++ header\n";
+        return 2;
+    }
+
+    try {
+        Lexer lexer;
+        if (!lexerFile.empty()) {
+            lexer = Lexer::load(lexerFile);
+        } else {
+            buildLexer(rulesFile, cacheDirectory, lexer);
+        }
+        std::ofstream out(outputFile);
+        if (!out) {
+            throw std::runtime_error("Cannot open '" + outputFile + "' for writing");
+        }
+        generateScanner(lexer, options, out);
+        if (!out.flush()) {
+            throw std::runtime_error("Failed to write '" + outputFile + "'");
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "[Error]: " << e.what() << "\n";
+        return 1;
+    }
+    return 0;
+}
+
+int runLexCommand(int argc, char* argv[]) {
+    LexOptions options;
+    if (!parseLexOptions(argc, argv, options)) {
+        printLexUsage();
+        return 2;
+    }
+
+    Lexer lexer;
+    try {
+        if (!options.lexerFile.empty()) {
+            lexer = Lexer::load(options.lexerFile);
+        } else {
+            buildLexer(options.rulesFile, options.cacheDirectory, lexer);
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "[Error]: " << e.what() << "\n";
+        return 1;
+    }
+
+    const std::vector<std::string>& inputs = options.inputs;
+    unsigned jobs = options.jobs > 0 ? options.jobs : defaultWorkerCount();
+    OrderedOutput output(inputs.size());
+    // 只有一个输入时文件级并行无从谈起，改为在文件内部按块并行
+    unsigned intraFileThreads = inputs.size() == 1 ? jobs : 1;
+    std::vector<std::vector<TokenSpan>> spanBuffers(jobs);   // 每个工作线程一个
+    std::mutex statusMutex;
+    int status = 0;
+
+    runWorkStealing(inputs.size(), jobs, [&](size_t index, unsigned worker) {
+        const std::string& file = inputs[index];
+        std::string out;
+        std::string error;
+        try {
+            if (file == "-") {
+                lexStandardInput(lexer, file, index, output, out);
+            } else {
+                lexMappedFile(lexer, file, intraFileThreads, index, output, spanBuffers[worker], out);
+            }
+        } catch (const std::exception& e) {
+            // 出错文件的记录不输出（标准输入已写出的部分除外）
+            out.clear();
+            error = file + ": " + e.what();
+            std::lock_guard<std::mutex> lock(statusMutex);
+            status = 1;
+        }
+        output.finish(index, std::move(out), std::move(error));
+    });
+    std::fflush(stdout);
+    return status;
+}
@@ -0,0 +1,25 @@
+/*
+ * batch_cli.h - declares the non-interactive command-line entry points of regex_automata.
+ * - lex: builds a lexer once (from a rules file or the predefined lang.l tokens) and
+ * tokenizes any number of input files in a single invocation, writing one tab-separated
+ * record per token to stdout; with '--lexer' it loads a compiled lexer instead of building.
+ * - compile: builds a lexer once and saves it as a binary image that 'lex --lexer' maps.
+ * - gen: generates a standalone C++ scanner from the rules or a compiled lexer.
+ */
+#pragma once
+
+/**
+ * regex_automata lex [--rules FILE | --lexer FILE] [--jobs N] --input FILE...
+ * args 为子命令之后的参数；返回进程退出码
+ */
+int runLexCommand(int argc, char* argv[]);
+
+/**
+ * regex_automata compile [--rules FILE] --output FILE
+ */
+int runCompileCommand(int argc, char* argv[]);
+
+/**
+ * regex_automata gen [--rules FILE | --lexer FILE] [--style direct|table] [--namespace NAME] --output FILE
+ */
+int runGenCommand(int argc, char* argv[]);
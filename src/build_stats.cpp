@@ -0,0 +1,89 @@
+/*
+ * build_stats.cpp - implements the process-wide build log sink (an atomic function pointer, so
+ * it can be swapped while other threads build), the text form of BuildStats and
+ * PeakMemoryMeter (Linux /proc only; elsewhere it reports 0).
+ */
+#include "build_stats.h"
+#include <atomic>
+#include <fstream>
+#include <string>
+
+namespace {
+
+std::atomic<BuildLogSink> g_buildLogSink{nullptr};
+
+} // namespace
+
+void setBuildLogSink(BuildLogSink sink) {
+    g_buildLogSink.store(sink, std::memory_order_release);
+}
+
+BuildLogSink buildLogSink() {
+    return g_buildLogSink.load(std::memory_order_acquire);
+}
+
+void writeBuildStats(const BuildStats& stats, std::ostream& out) {
+    out << "from_cache " << (stats.fromCache ? 1 : 0) << "\n"
+        << "preprocess_seconds " << stats.preprocessSeconds << "\n"
+        << "simplify_seconds " << stats.simplifySeconds << "\n"
+        << "postfix_seconds " << stats.postfixSeconds << "\n"
+        << "thompson_seconds " << stats.thompsonSeconds << "\n"
+        << "subset_seconds " << stats.subsetSeconds << "\n"
+        << "minimize_seconds " << stats.minimizeSeconds << "\n"
+        << "table_seconds " << stats.tableSeconds << "\n"
+        << "total_seconds " << stats.totalSeconds << "\n"
+        << "token_classes " << stats.tokenClasses << "\n"
+        << "nfa_nodes " << stats.nfaNodes << "\n"
+        << "nfa_edges " << stats.nfaEdges << "\n"
+        << "dfa_states " << stats.dfaStates << "\n"
+        << "dfa_transitions " << stats.dfaTransitions << "\n"
+        << "min_dfa_states " << stats.minDfaStates << "\n"
+        << "min_dfa_transitions " << stats.minDfaTransitions << "\n"
+        << "accept_states " << stats.acceptStates << "\n"
+        << "canonical_inputs " << stats.canonicalInputs << "\n"
+        << "byte_classes " << stats.byteClasses << "\n"
+        << "state_id_bytes " << stats.stateIdBytes << "\n"
+        << "image_bytes " << stats.imageBytes << "\n"
+        << "peak_memory_bytes " << stats.peakMemoryBytes << "\n";
+}
+
+namespace {
+
+// /proc/self/status 中 "name: N kB" 一行的值（字节），读不到时返回 0
+size_t procStatusBytes(const char* name) {
+#if defined(__linux__)
+    std::ifstream in("/proc/self/status");
+    std::string line;
+    const size_t nameLength = std::char_traits<char>::length(name);
+    while (std::getline(in, line)) {
+        if (line.compare(0, nameLength, name) == 0 && line.size() > nameLength && line[nameLength] == ':') {
+            return static_cast<size_t>(std::stoull(line.substr(nameLength + 1))) * 1024;
+        }
+    }
+#else
+    (void)name;
+#endif
+    return 0;
+}
+
+} // namespace
+
+PeakMemoryMeter::PeakMemoryMeter(bool enabled) {
+    if (!enabled) return;
+#if defined(__linux__)
+    // 写入 "5" 把 VmHWM 重置为当前的 VmRSS（Linux 4.0 起）
+    std::ofstream clearRefs("/proc/self/clear_refs");
+    clearRefs << "5";
+    clearRefs.close();
+    if (clearRefs) {
+        startBytes_ = procStatusBytes("VmRSS");
+        active_ = startBytes_ > 0;
+    }
+#endif
+}
+
+size_t PeakMemoryMeter::peakBytes() const {
+    if (!active_) return 0;
+    size_t peak = procStatusBytes("VmHWM");
+    return peak > startBytes_ ? peak - startBytes_ : 0;
+}
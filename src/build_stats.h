@@ -0,0 +1,104 @@
+/*
+ * build_stats.h - build diagnostics for library users: structured statistics instead of text on
+ * std::cout. It defines:
+ * - BuildStats: what Lexer::build returns - per-stage wall time, NFA / DFA sizes, the canonical
+ * input and byte class counts and, when asked for, the resident memory the build itself added
+ * at its peak, ready to be exported to monitoring.
+ * - PeakMemoryMeter: measures that peak for one stretch of code (Linux: resets the process's
+ * resident high-water mark through /proc/self/clear_refs and reads VmHWM back). Because that
+ * changes process-wide counters, it only runs when enabled: Lexer::setMeasurePeakMemory, used
+ * by 'compile --stats'.
+ * - Build log sink: progress messages of the construction code go to a process-wide sink
+ * installed with 'setBuildLogSink'; none is installed by default, so library users see no
+ * output. BUILD_LOG formats its message only when a sink is installed, and compiles to nothing
+ * when REGEX_AUTOMATA_LOGGING is 0 (CMake option REGEX_AUTOMATA_LOGGING=OFF).
+ */
+#pragma once
+
+#include <cstddef>
+#include <ostream>
+#include <sstream>
+#include <string_view>
+
+#ifndef REGEX_AUTOMATA_LOGGING
+#define REGEX_AUTOMATA_LOGGING 1
+#endif
+
+/**
+ * Lexer::build 的统计结果；耗时单位为秒，命中构建缓存时只有 total 与表相关的字段有值
+ */
+struct BuildStats {
+    // 各阶段耗时：前四项为所有规则的合计
+    double preprocessSeconds = 0;     // preprocessRegex
+    double simplifySeconds = 0;       // simplifyRegex + insertConcatSymbols
+    double postfixSeconds = 0;        // InfixToPostfix::convert
+    double thompsonSeconds = 0;       // regexToNFA 与合并
+    double subsetSeconds = 0;         // buildDFAFromNFA
+    double minimizeSeconds = 0;       // 按类别标签最小化
+    double tableSeconds = 0;          // 转移表与映像编码（或读入缓存项）
+    double totalSeconds = 0;
+
+    size_t tokenClasses = 0;
+    size_t nfaNodes = 0;
+    size_t nfaEdges = 0;
+    size_t dfaStates = 0;             // 子集构造的结果
+    size_t dfaTransitions = 0;
+    size_t minDfaStates = 0;          // 最小化之后
+    size_t minDfaTransitions = 0;
+    size_t acceptStates = 0;
+    size_t canonicalInputs = 0;       // 子集构造使用的字符划分数
+    size_t byteClasses = 0;           // 转移表的字节等价类数
+    size_t stateIdBytes = 0;          // 转移表中状态 ID 的宽度
+    size_t imageBytes = 0;            // 二进制映像大小
+
+    size_t peakMemoryBytes = 0;       // 构建期间常驻内存峰值超出构建开始时的部分；未开启
+                                      // Lexer::setMeasurePeakMemory 或平台不支持时为 0
+    bool fromCache = false;           // 映像取自构建缓存，未运行构造
+};
+
+/**
+ * 以 "名称 值" 每行一项的文本形式输出（名称为小写加下划线，耗时以秒为单位），便于导入监控
+ */
+void writeBuildStats(const BuildStats& stats, std::ostream& out);
+
+/**
+ * 测量一段代码的常驻内存峰值：enabled 为真时，构造时重置进程的常驻内存高水位并记下当前常驻内存，
+ * 'peakBytes' 返回此后的高水位减去该值（字节）。只在 Linux 上可用（/proc/self/clear_refs），
+ * 未开启、其他平台或无法重置时什么也不做并返回 0。高水位为进程全局：同时运行的其他线程的分配
+ * 也计入，嵌套或并发的测量会互相重置，getrusage 的 ru_maxrss 也随之重置，所以只应在独占进程的
+ * 工具中开启
+ */
+class PeakMemoryMeter {
+public:
+    explicit PeakMemoryMeter(bool enabled);
+    size_t peakBytes() const;
+
+private:
+    size_t startBytes_ = 0;
+    bool active_ = false;
+};
+
+/**
+ * 日志接收器：一条进度消息（不含换行）；nullptr 表示丢弃
+ * 接收器为进程全局，可在任何时候替换，可能被多个线程同时调用
+ */
+using BuildLogSink = void (*)(std::string_view message);
+
+void setBuildLogSink(BuildLogSink sink);
+BuildLogSink buildLogSink();
+
+#if REGEX_AUTOMATA_LOGGING
+// 用法：BUILD_LOG("DFA built: " << states << " states")；没有接收器时不格式化
+#define BUILD_LOG(message)                                  \
+    do {                                                    \
+        if (BuildLogSink buildLogSink_ = buildLogSink()) {  \
+            std::ostringstream buildLogStream_;             \
+            buildLogStream_ << message;                     \
+            buildLogSink_(buildLogStream_.str());           \
+        }                                                   \
+    } while (0)
+#else
+#define BUILD_LOG(message) \
+    do {                   \
+    } while (0)
+#endif
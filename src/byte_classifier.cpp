@@ -0,0 +1,109 @@
+/*
+ * byte_classifier.cpp - builds the nibble tables of a ByteClassifier and implements the scalar,
+ * SSSE3 and AVX2 classification kernels. A vector kernel splits every byte into its low and
+ * high nibble; for each kept row it shuffles the row by the low nibbles, masks the result with
+ * the row's high-nibble selector (itself a shuffle by the high nibbles) and ORs it into the
+ * block. The tail shorter than one vector uses the scalar table.
+ */
+#include "byte_classifier.h"
+#include "lexer_table.h"
+#include <cstring>
+
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#define BYTE_CLASSIFIER_HAS_SIMD
+#include <immintrin.h>
+#endif
+
+namespace {
+
+void classifyScalar(const ByteClassifier& classifier, const char* data, size_t length, uint8_t* classes) {
+    for (size_t i = 0; i < length; ++i) classes[i] = classifier.byteClass[static_cast<unsigned char>(data[i])];
+}
+
+#ifdef BYTE_CLASSIFIER_HAS_SIMD
+__attribute__((target("ssse3")))
+void classifySSSE3(const ByteClassifier& classifier, const char* data, size_t length, uint8_t* classes) {
+    __m128i rows[16], select[16];
+    const int numRows = classifier.numRows;
+    for (int k = 0; k < numRows; ++k) {
+        rows[k] = _mm_loadu_si128(reinterpret_cast<const __m128i*>(classifier.rows[k]));
+        select[k] = _mm_loadu_si128(reinterpret_cast<const __m128i*>(classifier.rowSelect[k]));
+    }
+    const __m128i nibble = _mm_set1_epi8(0x0F);
+    size_t i = 0;
+    for (; length - i >= 16; i += 16) {
+        __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+        __m128i low = _mm_and_si128(bytes, nibble);
+        __m128i high = _mm_and_si128(_mm_srli_epi16(bytes, 4), nibble);
+        __m128i result = _mm_setzero_si128();
+        for (int k = 0; k < numRows; ++k) {
+            __m128i value = _mm_shuffle_epi8(rows[k], low);
+            result = _mm_or_si128(result, _mm_and_si128(value, _mm_shuffle_epi8(select[k], high)));
+        }
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(classes + i), result);
+    }
+    classifyScalar(classifier, data + i, length - i, classes + i);
+}
+
+__attribute__((target("avx2")))
+void classifyAVX2(const ByteClassifier& classifier, const char* data, size_t length, uint8_t* classes) {
+    // vpshufb 在两个 128 位半区内各自查表，因此 16 项的表复制到两半
+    __m256i rows[16], select[16];
+    const int numRows = classifier.numRows;
+    for (int k = 0; k < numRows; ++k) {
+        rows[k] = _mm256_broadcastsi128_si256(_mm_loadu_si128(reinterpret_cast<const __m128i*>(classifier.rows[k])));
+        select[k] = _mm256_broadcastsi128_si256(_mm_loadu_si128(reinterpret_cast<const __m128i*>(classifier.rowSelect[k])));
+    }
+    const __m256i nibble = _mm256_set1_epi8(0x0F);
+    size_t i = 0;
+    for (; length - i >= 32; i += 32) {
+        __m256i bytes = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i));
+        __m256i low = _mm256_and_si256(bytes, nibble);
+        __m256i high = _mm256_and_si256(_mm256_srli_epi16(bytes, 4), nibble);
+        __m256i result = _mm256_setzero_si256();
+        for (int k = 0; k < numRows; ++k) {
+            __m256i value = _mm256_shuffle_epi8(rows[k], low);
+            result = _mm256_or_si256(result, _mm256_and_si256(value, _mm256_shuffle_epi8(select[k], high)));
+        }
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(classes + i), result);
+    }
+    classifyScalar(classifier, data + i, length - i, classes + i);
+}
+#endif
+
+} // namespace
+
+std::shared_ptr<const ByteClassifier> buildByteClassifier(const LexerTable& table, SimdLevel level) {
+    auto classifier = std::make_shared<ByteClassifier>();
+    std::memcpy(classifier->byteClass, table.byteClass, 256);
+
+    // 高半字节相同的 16 个字节构成一行；内容相同的行合并，全 0 的行不需要查表
+    for (int high = 0; high < 16; ++high) {
+        const uint8_t* row = table.byteClass + high * 16;
+        bool zero = true;
+        for (int low = 0; low < 16; ++low) zero = zero && row[low] == 0;
+        if (zero) continue;
+
+        int k = 0;
+        while (k < classifier->numRows && std::memcmp(classifier->rows[k], row, 16) != 0) ++k;
+        if (k == classifier->numRows) {
+            std::memcpy(classifier->rows[k], row, 16);
+            ++classifier->numRows;
+        }
+        classifier->rowSelect[k][high] = 0xFF;
+    }
+
+    classifier->classify = classifyScalar;
+#ifdef BYTE_CLASSIFIER_HAS_SIMD
+    if (level == SimdLevel::AVX2 && __builtin_cpu_supports("avx2")) {
+        classifier->classify = classifyAVX2;
+        classifier->level = SimdLevel::AVX2;
+    } else if (level != SimdLevel::None && __builtin_cpu_supports("ssse3")) {
+        classifier->classify = classifySSSE3;
+        classifier->level = SimdLevel::SSE2;
+    }
+#else
+    (void)level;
+#endif
+    return classifier;
+}
@@ -0,0 +1,51 @@
+/*
+ * byte_classifier.h - vectorized byte -> equivalence class translation of whole input blocks,
+ * used by the class-stream scanner (Lexer::tokenizeSpansClassified). It features:
+ * - Nibble decomposition: the 256-entry byte class map (the disjoint canonical inputs of
+ * subset construction) is cut into 16 rows by high nibble; a row is a 16-entry low nibble ->
+ * class table, which is exactly one byte shuffle (pshufb). High nibbles with identical rows
+ * share one shuffle, and all-zero rows (typically 0x80-0xFF) need none, so the cost per block
+ * grows with the number of distinct rows rather than with the number of classes.
+ * - Kernels: 16 bytes per step with SSSE3 (SimdLevel::SSE2) or 32 with AVX2, both reached
+ * through target attributes and checked against the CPU at build time; SimdLevel::None, CPUs
+ * without SSSE3 and builds without x86 vectors classify with the scalar table.
+ */
+#pragma once
+
+#include "self_loop.h"
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+struct LexerTable;
+
+/**
+ * 按高半字节拆分的等价类表：字节 b 的类别为 rows[k][b & 15]，其中 k 为满足
+ * rowSelect[k][b >> 4] == 0xFF 的行；不匹配任何行的字节类别为 0
+ */
+struct ByteClassifier {
+    // 类别流扫描器一次分类的字节数
+    static constexpr size_t kBlockSize = 4096;
+
+    // 把 data[0, length) 的等价类编号写入 classes[0, length)
+    using ClassifyFn = void (*)(const ByteClassifier& classifier, const char* data, size_t length,
+                                uint8_t* classes);
+
+    uint8_t byteClass[256] = {};      // 标量路径与块尾
+    int numRows = 0;                  // 不全为 0 的不同行数
+    uint8_t rows[16][16] = {};        // rows[k][低半字节] = 类别
+    uint8_t rowSelect[16][16] = {};   // rowSelect[k][高半字节] = 0xFF 表示该高半字节使用第 k 行
+    ClassifyFn classify = nullptr;
+    SimdLevel level = SimdLevel::None;
+};
+
+/**
+ * 为 table 建立分类器；level 不被当前平台支持时退回标量分类，因此总是返回可用的分类器
+ */
+std::shared_ptr<const ByteClassifier> buildByteClassifier(const LexerTable& table,
+                                                          SimdLevel level = detectSimdLevel());
+
+inline void classifyBytes(const ByteClassifier& classifier, const char* data, size_t length,
+                          uint8_t* classes) {
+    classifier.classify(classifier, data, length, classes);
+}
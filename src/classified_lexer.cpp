@@ -0,0 +1,82 @@
+/*
+ * classified_lexer.cpp - implements Lexer::tokenizeSpansClassified, the pre-classified scanner
+ * mode. It features:
+ * - Block classification: a window of up to ByteClassifier::kBlockSize class ids is filled by
+ * the table's vectorized classifier; the DFA loop then reads one class byte per step instead of
+ * looking each input byte up in the 256-entry map, so the byte -> class translation leaves the
+ * dependent chain of table loads.
+ * - Lookahead across blocks: a match that runs past the window refills it from the current
+ * position. When longest match backs up to a token end before the window, the window is
+ * refilled from there; only the bytes read past the last accept are classified twice.
+ * - Same results: tokens, actions and lexical errors are those of tokenizeSpans.
+ */
+#include "lexer.h"
+#include <algorithm>
+
+void Lexer::tokenizeSpansClassified(std::string_view input, std::vector<TokenSpan>& out) const {
+    if (!isBuilt_) {
+        throw std::runtime_error("Lexer not built. Call build() first.");
+    }
+
+    switch (table_.width) {
+        case StateWidth::U8:  tokenizeSpansClassifiedWithTable<uint8_t>(input, out); break;
+        case StateWidth::U16: tokenizeSpansClassifiedWithTable<uint16_t>(input, out); break;
+        case StateWidth::U32: tokenizeSpansClassifiedWithTable<uint32_t>(input, out); break;
+    }
+}
+
+template <typename StateT>
+void Lexer::tokenizeSpansClassifiedWithTable(std::string_view input, std::vector<TokenSpan>& out) const {
+    const StateT* next = table_.next<StateT>();
+    const int32_t* accept = table_.acceptClass;
+    const TokenAction* actions = table_.classAction;
+    const size_t numClasses = static_cast<size_t>(table_.numClasses);
+    const ByteClassifier& classifier = *table_.classifier;
+    const size_t length = input.length();
+
+    // 当前窗口 [windowBegin, windowEnd) 的类别编号
+    uint8_t classes[ByteClassifier::kBlockSize];
+    size_t windowBegin = 0, windowEnd = 0;
+
+    out.clear();
+    size_t pos = 0;
+    while (pos < length) {
+        size_t state = LexerTable::kStartRow;
+        size_t lastEnd = pos;
+        int lastClass = -1;
+
+        size_t i = pos;
+        while (i < length) {
+            if (i < windowBegin || i >= windowEnd) {
+                windowBegin = i;
+                windowEnd = std::min(length, i + ByteClassifier::kBlockSize);
+                classifyBytes(classifier, input.data() + windowBegin, windowEnd - windowBegin, classes);
+            }
+            for (; i < windowEnd; ++i) {
+                state = next[state * numClasses + classes[i - windowBegin]];
+                if (state == LexerTable::kDeadRow) break;
+                if (accept[state] >= 0) {
+                    lastEnd = i + 1;
+                    lastClass = accept[state];
+                }
+            }
+            if (state == LexerTable::kDeadRow) break;
+        }
+        if (lastEnd == pos) {
+            throwLexicalError(input, pos);
+        }
+
+        TokenSpan span = makeTokenSpan(pos, lastEnd - pos, lastClass);
+        switch (actions[lastClass]) {
+            case TokenAction::Emit:
+                out.push_back(span);
+                break;
+            case TokenAction::Callback:
+                if (tokenCallbacks_[lastClass]) tokenCallbacks_[lastClass](span, input.substr(pos, lastEnd - pos));
+                break;
+            default:
+                break;
+        }
+        pos = lastEnd;
+    }
+}
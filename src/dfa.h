@@ -1,22 +1,29 @@
 /*
  * dfa.h - declares the data structures and functions for DFA construction
  * from an NFA using subset construction. It defines:
- * - DFAState: a DFA state represented by a unique ID, a set of NFA state IDs it corresponds to,
+ * - DFAState: a DFA state represented by a unique ID, a sorted vector of the NFA state IDs it corresponds to,
  * and a human-readable name; it supports comparison via the underlying NFA state set.
  * - DFATransition: a deterministic transition between two DFA states labeled by a 'CharSet'.
+ * - CompactNFA: an immutable, adjacency-indexed (CSR) form of an NFAUnit with dense node ids,
+ * used by subset construction for closure and move.
  */
 #pragma once
 
 #include <string>
 #include <vector>
 #include <set>
+#include <algorithm>
 #include "nfa.h"
 
 struct DFAState {
     int id;
-    std::set<int> nfaStates;
+    std::vector<int> nfaStates; // 有序、无重复的 NFA 状态 ID
     std::string stateName;
 
+    bool contains(int nfaState) const {
+        return std::binary_search(nfaStates.begin(), nfaStates.end(), nfaState);
+    }
+
     bool operator==(const DFAState& other) const {
         return nfaStates == other.nfaStates;
     }
@@ -31,13 +38,51 @@ struct DFATransition {
     CharSet transitionSymbol; // Change string to CharSet
 };
 
-DFAState epsilonClosure(const std::set<int>& states, const NFAUnit& nfa);
+/**
+ * 紧凑 NFA：节点重新编号为 0..numNodes-1，出边按起点分组存放在 CSR 数组中，
+ * epsilon 边与带标签边分开存放
+ */
+struct CompactNFA {
+    // 带标签边：覆盖 canonical inputs 中下标 [inputBegin, inputEnd) 的输入
+    struct LabeledEdge {
+        int target;
+        int inputBegin;
+        int inputEnd;
+    };
 
-DFAState move(const DFAState& state, const CharSet& symbol, const NFAUnit& nfa);
+    int numNodes = 0;
+    int start = -1;
+    std::vector<int> originalIds;       // 稠密编号 -> NFAUnit 中的节点 ID
+    std::vector<CharSet> inputs;        // 互不相交的输入字符集
 
+    // 节点 u 的 epsilon 后继为 epsTargets[epsOffsets[u] .. epsOffsets[u+1])
+    std::vector<int> epsOffsets;
+    std::vector<int> epsTargets;
+
+    // 节点 u 的带标签出边为 labeledEdges[labeledOffsets[u] .. labeledOffsets[u+1])
+    std::vector<int> labeledOffsets;
+    std::vector<LabeledEdge> labeledEdges;
+};
+
+CompactNFA buildCompactNFA(const NFAUnit& nfa);
+
+// 由 NFA 边上的所有区间边界切分出互不相交的输入字符集
+std::vector<CharSet> getCanonicalInputs(const NFAUnit& nfa);
+
+// canonicalInputs 非空时输出子集构造所用的字符划分（每条 DFA 转移恰好标记其中一个）
 void buildDFAFromNFA(const NFAUnit& nfa,
                      std::vector<DFAState>& dfaStates,
-                     std::vector<DFATransition>& dfaTransitions);
+                     std::vector<DFATransition>& dfaTransitions,
+                     std::vector<CharSet>* canonicalInputs = nullptr);
+
+// 按初始标签划分的 DFA 最小化：stateLabels[i] 为 dfaStates[i] 的标签，标签不同的状态不会合并；
+// stateMapping[i] 输出 dfaStates[i] 在最小化 DFA 中的状态 ID
+void minimizeDFAWithLabels(const std::vector<DFAState>& dfaStates,
+                           const std::vector<DFATransition>& dfaTransitions,
+                           const std::vector<int>& stateLabels,
+                           std::vector<DFAState>& minDfaStates,
+                           std::vector<DFATransition>& minDfaTransitions,
+                           std::vector<int>& stateMapping);
 
 // 新增：DFA 最小化函数
 void minimizeDFA(const std::vector<DFAState>& dfaStates,
@@ -1,14 +1,27 @@
 /*
  * dfa_converter.cpp - implements the subset construction algorithm to convert an NFA into a DFA.
  * Key features include:
- * - Epsilon-closure computation with per-node caching to avoid redundant DFS traversals.
- * - A 'move' function that computes reachable NFA states from a DFA state on a single input charact
- * - Automatic alphabet extraction from NFA transitions, limited to printable ASCII characters
- * (0-127) to keep the DFA manageable.
+ * - CompactNFA: an immutable adjacency-indexed form of the NFA built once per conversion.
+ * Node ids are renumbered densely, and out-edges are grouped per node in compressed-sparse-row
+ * arrays, with epsilon edges and labelled edges kept apart, so closure and move only touch
+ * the edges of the nodes they visit.
+ * - Labelled edges are pre-resolved against the canonical inputs: each stores the half-open
+ * range of input indices it covers, so 'move' is an integer range test instead of a CharSet match.
+ * - Epsilon-closure computation by DFS over the epsilon CSR arrays, using a generation-stamped
+ * visited array and reusable scratch buffers, so subset construction does no per-step heap
+ * allocation once the buffers have grown.
+ * - 'move' for all inputs at once: the labelled out-edges of a DFA state's NFA nodes are
+ * bucketed by canonical input in a single pass.
+ * - DFA states are sorted vectors of NFA node ids stored back to back in one pool and interned
+ * through an open-addressing table keyed by a 64-bit hash of the set.
+ * - Automatic alphabet extraction from NFA transitions: all range boundaries are collected and
+ * cut into disjoint canonical inputs.
  * - BFS-driven DFA state exploration, where each DFA state corresponds to a unique set of NFA state.
- * - Transition deduplication to avoid redundant edges between the same state pair on the same symbol.
- * - Support for 'CharSet'-based symbols (from nfa.h) in transitions, though the current implementation
- * processes transitions character-by-character during construction and creates one 'CharSet' per char.
+ * Every (DFA state, input) pair is visited exactly once, so no duplicate transitions are produced.
+ * - Support for 'CharSet'-based symbols (from nfa.h) in transitions: each DFA transition is
+ * labelled with one canonical input.
+ * - The disjoint canonical inputs can be handed back to the caller, which the lexer uses to
+ * derive its byte equivalence classes.
  */
 #include "dfa.h"
 #include <queue>
@@ -16,96 +29,7 @@
 #include <map>
 #include <vector>
 #include <set>
-
-// 全局缓存：NFA节点ID -> Epsilon闭包集合
-static std::map<int, std::set<int>> closureCache;
-
-// 计算单个状态的 Epsilon Closure (带缓存的 DFS/BFS)
-std::set<int> getSingleNodeClosure(int startNodeId, const NFAUnit& nfa) {
-    if (closureCache.count(startNodeId)) {
-        return closureCache[startNodeId];
-    }
-
-    std::set<int> closure;
-    std::vector<int> stack;
-    
-    stack.push_back(startNodeId);
-    closure.insert(startNodeId);
-
-    while (!stack.empty()) {
-        int u = stack.back();
-        stack.pop_back();
-
-        for (const Edge& e : nfa.edges) {
-            if (e.startName->id == u && e.symbol.isEpsilon) {
-                int v = e.endName->id;
-                if (closure.find(v) == closure.end()) {
-                    closure.insert(v);
-                    stack.push_back(v);
-                }
-            }
-        }
-    }
-
-    closureCache[startNodeId] = closure;
-    return closure;
-}
-
-// 优化后的集合闭包计算
-std::set<int> getEpsilonClosure(const std::set<int>& states, const NFAUnit& nfa) {
-    std::set<int> result;
-    for (int id : states) {
-        if (closureCache.find(id) == closureCache.end()) {
-            getSingleNodeClosure(id, nfa);
-        }
-        const auto& singleClosure = closureCache[id];
-        result.insert(singleClosure.begin(), singleClosure.end());
-    }
-    return result;
-}
-
-DFAState epsilonClosure(const std::set<int>& states, const NFAUnit& nfa) {
-    auto closureSet = getEpsilonClosure(states, nfa);
-    DFAState state;
-    state.nfaStates = closureSet;
-    return state;
-}
-
-DFAState move(const DFAState& state, const CharSet& symbol, const NFAUnit& nfa) {
-    std::set<int> targetStates;
-    // Use a representative character from the disjoint input set to check coverage
-    char representative = 0;
-    if (!symbol.ranges.empty()) {
-        representative = symbol.ranges.begin()->start;
-    }
-
-    for (int nfaStateId : state.nfaStates) {
-        for (const Edge& e : nfa.edges) {
-            // Instead of exact equality (e.symbol == symbol), check if edge covers the input range.
-            // Since 'symbol' comes from a disjoint partition of all boundaries, 
-            // e.symbol covers 'symbol' iff it matches a representative char.
-            if (!e.symbol.isEpsilon && e.startName->id == nfaStateId && e.symbol.match(representative)) {
-                targetStates.insert(e.endName->id);
-            }
-        }
-    }
-    DFAState nextState;
-    nextState.nfaStates = targetStates;
-    return nextState;
-}
-
-bool isTransitionInVector(int fromId, int toId,
-                          const CharSet& symbol,
-                          const std::vector<DFATransition>& transitions) {
-    for (const auto& t : transitions) {
-        if (t.fromStateId == fromId &&
-            t.toStateId == toId &&
-            t.transitionSymbol == symbol) {
-            return true;
-        }
-    }
-    return false;
-}
+#include <cstdint>
 
 // Helper to generate disjoint canonical inputs from NFA edges
 std::vector<CharSet> getCanonicalInputs(const NFAUnit& nfa) {
@@ -135,48 +59,249 @@ std::vector<CharSet> getCanonicalInputs(const NFAUnit& nfa) {
     return inputs;
 }
 
-void buildDFAFromNFA(const NFAUnit& nfa,
-                     std::vector<DFAState>& dfaStates,
-                     std::vector<DFATransition>& dfaTransitions) {
-    closureCache.clear(); 
-    
-    std::map<std::set<int>, int> existingStates;
-    int dfaCounter = 0;
-
-    std::set<int> initSet = {nfa.start->id};
-    DFAState initState = epsilonClosure(initSet, nfa);
-    initState.id = dfaCounter++;
-    initState.stateName = std::to_string(initState.id);
-    
-    dfaStates.push_back(initState);
-    existingStates[initState.nfaStates] = initState.id;
-
-    // Collect disjoint input ranges covering all transitions
-    std::vector<CharSet> inputs = getCanonicalInputs(nfa);
-
-    for (size_t i = 0; i < dfaStates.size(); ++i) {
-        DFAState current = dfaStates[i]; 
-
-        for (const auto& symbol : inputs) {
-            DFAState moved = move(current, symbol, nfa);
-            if (!moved.nfaStates.empty()) {
-                DFAState closure = epsilonClosure(moved.nfaStates, nfa);
-
-                auto it = existingStates.find(closure.nfaStates);
-                if (it == existingStates.end()) {
-                    closure.id = dfaCounter++;
-                    closure.stateName = std::to_string(closure.id);
-                    dfaStates.push_back(closure);
-                    existingStates[closure.nfaStates] = closure.id;
-                } else {
-                    closure.id = it->second;
-                    closure.stateName = dfaStates[it->second].stateName;
+CompactNFA buildCompactNFA(const NFAUnit& nfa) {
+    CompactNFA compact;
+    compact.inputs = getCanonicalInputs(nfa);
+
+    // 1. 节点稠密编号
+    std::map<int, int> denseId;
+    auto numberNode = [&](int id) {
+        auto it = denseId.find(id);
+        if (it != denseId.end()) return it->second;
+        int dense = static_cast<int>(compact.originalIds.size());
+        denseId.emplace(id, dense);
+        compact.originalIds.push_back(id);
+        return dense;
+    };
+    compact.start = numberNode(nfa.start);
+    for (const Edge& e : nfa.edges) {
+        numberNode(e.startId);
+        numberNode(e.endId);
+    }
+    compact.numNodes = static_cast<int>(compact.originalIds.size());
+
+    // 每个输入区间的起点，用于把边上的字符区间映射为输入下标区间
+    std::vector<int> inputStarts;
+    inputStarts.reserve(compact.inputs.size());
+    for (const auto& input : compact.inputs) {
+        inputStarts.push_back(static_cast<int>(input.ranges.begin()->start));
+    }
+    auto inputIndexOf = [&inputStarts](int c) {
+        return static_cast<int>(std::upper_bound(inputStarts.begin(), inputStarts.end(), c)
+                                - inputStarts.begin()) - 1;
+    };
+
+    // 2. 统计出度
+    const size_t numNodes = static_cast<size_t>(compact.numNodes);
+    compact.epsOffsets.assign(numNodes + 1, 0);
+    compact.labeledOffsets.assign(numNodes + 1, 0);
+    for (const Edge& e : nfa.edges) {
+        int u = denseId[e.startId];
+        if (e.symbol.isEpsilon) {
+            ++compact.epsOffsets[u + 1];
+        } else {
+            compact.labeledOffsets[u + 1] += static_cast<int>(e.symbol.ranges.size());
+        }
+    }
+    for (size_t i = 1; i <= numNodes; ++i) {
+        compact.epsOffsets[i] += compact.epsOffsets[i - 1];
+        compact.labeledOffsets[i] += compact.labeledOffsets[i - 1];
+    }
+
+    // 3. 填充 CSR 数组
+    compact.epsTargets.resize(compact.epsOffsets.back());
+    compact.labeledEdges.resize(compact.labeledOffsets.back());
+    std::vector<int> epsFill(compact.epsOffsets.begin(), compact.epsOffsets.end() - 1);
+    std::vector<int> labeledFill(compact.labeledOffsets.begin(), compact.labeledOffsets.end() - 1);
+    for (const Edge& e : nfa.edges) {
+        int u = denseId[e.startId];
+        int v = denseId[e.endId];
+        if (e.symbol.isEpsilon) {
+            compact.epsTargets[epsFill[u]++] = v;
+        } else {
+            for (const auto& r : e.symbol.ranges) {
+                int first = inputIndexOf(static_cast<int>(r.start));
+                int last = inputIndexOf(static_cast<int>(r.end));
+                compact.labeledEdges[labeledFill[u]++] = {v, first, last + 1};
+            }
+        }
+    }
+    return compact;
+}
+
+namespace {
+
+// 64 位哈希（FNV-1a 变体，按 int 混合）
+uint64_t hashStateSet(const int* begin, const int* end) {
+    uint64_t h = 1469598103934665603ULL;
+    for (const int* p = begin; p != end; ++p) {
+        h ^= static_cast<uint32_t>(*p);
+        h *= 1099511628211ULL;
+        h ^= h >> 29;
+    }
+    return h;
+}
+
+/**
+ * 子集构造的工作区：DFA 状态的 NFA 集合以有序数组形式连续存放在 setPool 中，
+ * 通过 64 位哈希的开放寻址表去重；所有临时缓冲区在各步之间复用
+ */
+class SubsetBuilder {
+public:
+    explicit SubsetBuilder(const CompactNFA& nfa)
+        : nfa_(nfa), stamp_(nfa.numNodes, 0), buckets_(nfa.inputs.size()) {
+        setOffsets_.push_back(0);
+        slots_.assign(64, -1);
+    }
+
+    int stateCount() const { return static_cast<int>(stateHashes_.size()); }
+    const int* setBegin(int state) const { return setPool_.data() + setOffsets_[state]; }
+    const int* setEnd(int state) const { return setPool_.data() + setOffsets_[state + 1]; }
+
+    // 计算 seeds 的 epsilon 闭包（结果有序，存于 scratch_），返回对应 DFA 状态 ID；
+    // isNew 表示该状态是否为新建
+    int internClosure(const std::vector<int>& seeds, bool& isNew) {
+        ++generation_;
+        scratch_.clear();
+        stack_.clear();
+        for (int u : seeds) {
+            if (stamp_[u] != generation_) {
+                stamp_[u] = generation_;
+                scratch_.push_back(u);
+                stack_.push_back(u);
+            }
+        }
+        while (!stack_.empty()) {
+            int u = stack_.back();
+            stack_.pop_back();
+            for (int i = nfa_.epsOffsets[u]; i < nfa_.epsOffsets[u + 1]; ++i) {
+                int v = nfa_.epsTargets[i];
+                if (stamp_[v] != generation_) {
+                    stamp_[v] = generation_;
+                    scratch_.push_back(v);
+                    stack_.push_back(v);
                 }
+            }
+        }
+        std::sort(scratch_.begin(), scratch_.end());
+        return intern(isNew);
+    }
 
-                if (!isTransitionInVector(current.id, closure.id, symbol, dfaTransitions)) {
-                    dfaTransitions.push_back({current.id, closure.id, symbol});
+    // 对状态 state 的所有带标签出边按输入分桶：buckets_[input] 为 move(state, input)
+    // 返回非空桶对应的输入（升序）
+    const std::vector<int>& moveAll(int state) {
+        for (int input : activeInputs_) buckets_[input].clear();
+        activeInputs_.clear();
+
+        // setPool_ 在 intern 时可能扩容，这里按下标访问
+        for (int k = setOffsets_[state]; k < setOffsets_[state + 1]; ++k) {
+            int u = setPool_[k];
+            for (int i = nfa_.labeledOffsets[u]; i < nfa_.labeledOffsets[u + 1]; ++i) {
+                const auto& e = nfa_.labeledEdges[i];
+                for (int input = e.inputBegin; input < e.inputEnd; ++input) {
+                    if (buckets_[input].empty()) activeInputs_.push_back(input);
+                    buckets_[input].push_back(e.target);
                 }
             }
         }
+        std::sort(activeInputs_.begin(), activeInputs_.end());
+        return activeInputs_;
     }
-}
\ No newline at end of file
+
+    const std::vector<int>& bucket(int input) const { return buckets_[input]; }
+
+private:
+    int intern(bool& isNew) {
+        const int* begin = scratch_.data();
+        const int* end = begin + scratch_.size();
+        uint64_t h = hashStateSet(begin, end);
+        size_t mask = slots_.size() - 1;
+
+        for (size_t slot = h & mask;; slot = (slot + 1) & mask) {
+            int existing = slots_[slot];
+            if (existing < 0) break;
+            if (stateHashes_[existing] == h &&
+                std::equal(begin, end, setBegin(existing), setEnd(existing))) {
+                isNew = false;
+                return existing;
+            }
+        }
+
+        int id = stateCount();
+        setPool_.insert(setPool_.end(), begin, end);
+        setOffsets_.push_back(static_cast<int>(setPool_.size()));
+        stateHashes_.push_back(h);
+        if (static_cast<size_t>(stateCount()) * 2 > slots_.size()) {
+            rehash(slots_.size() * 2);
+        } else {
+            insertSlot(id);
+        }
+        isNew = true;
+        return id;
+    }
+
+    void insertSlot(int id) {
+        size_t mask = slots_.size() - 1;
+        size_t slot = stateHashes_[id] & mask;
+        while (slots_[slot] >= 0) slot = (slot + 1) & mask;
+        slots_[slot] = id;
+    }
+
+    void rehash(size_t newSize) {
+        slots_.assign(newSize, -1);
+        for (int id = 0; id < stateCount(); ++id) insertSlot(id);
+    }
+
+    const CompactNFA& nfa_;
+
+    std::vector<int> setPool_;        // 所有 DFA 状态的 NFA 集合（有序）
+    std::vector<int> setOffsets_;     // 状态 s 的集合为 setPool_[setOffsets_[s] .. setOffsets_[s+1])
+    std::vector<uint64_t> stateHashes_;
+    std::vector<int> slots_;          // 开放寻址哈希表，存 DFA 状态 ID
+
+    // 可复用的临时缓冲区
+    std::vector<uint32_t> stamp_;     // 访问标记（按 generation_ 判断）
+    uint32_t generation_ = 0;
+    std::vector<int> scratch_;
+    std::vector<int> stack_;
+    std::vector<std::vector<int>> buckets_;
+    std::vector<int> activeInputs_;
+};
+
+} // namespace
+
+void buildDFAFromNFA(const NFAUnit& nfa,
+                     std::vector<DFAState>& dfaStates,
+                     std::vector<DFATransition>& dfaTransitions,
+                     std::vector<CharSet>* canonicalInputs) {
+    CompactNFA compact = buildCompactNFA(nfa);
+    SubsetBuilder builder(compact);
+
+    bool isNew = false;
+    builder.internClosure({compact.start}, isNew);
+
+    // BFS：状态按创建顺序编号，新状态总是追加在末尾
+    for (int current = 0; current < builder.stateCount(); ++current) {
+        for (int input : builder.moveAll(current)) {
+            int target = builder.internClosure(builder.bucket(input), isNew);
+            dfaTransitions.push_back({current, target, compact.inputs[input]});
+        }
+    }
+
+    // 输出 DFA 状态，NFA 节点换回原始 ID
+    dfaStates.reserve(dfaStates.size() + builder.stateCount());
+    for (int id = 0; id < builder.stateCount(); ++id) {
+        DFAState state;
+        state.id = id;
+        state.stateName = std::to_string(id);
+        for (const int* p = builder.setBegin(id); p != builder.setEnd(id); ++p) {
+            state.nfaStates.push_back(compact.originalIds[*p]);
+        }
+        std::sort(state.nfaStates.begin(), state.nfaStates.end());
+        dfaStates.push_back(std::move(state));
+    }
+
+    if (canonicalInputs) {
+        *canonicalInputs = std::move(compact.inputs);
+    }
+}
@@ -1,262 +1,270 @@
 /*
- * dfa_minimizer.cpp - implements a DFA minimization algorithm based on partition refinement.
- * It takes a DFA (represented by `dfaStates` and `dfaTransitions`) and reduces it to
- * an equivalent minimal DFA by merging indistinguishable states. Key steps:
- * - Initial partitioning of states into accepting and non-accepting sets,
- * where acceptance is determined by whether the state's underlying NFA state set
- * contains the original NFA's final state (`originalNFAEndId`).
- * - Iterative refinement of partitions: states in the same partition are split
- * if they exhibit different transition behaviors (i.e., they transition to
- * states in different partitions) under any input symbol from the DFA's alphabet.
- * - Transition signatures are computed per state by recording, for every symbol
- * in the alphabet, the partition index of the target state (or -1 if no transition).
- * - After convergence, a minimized DFA is constructed where each partition becomes
- * a single state, preserving the original start state and acceptance condition.
- * - Transitions in the minimized DFA are derived from a representative state of each
- * partition, with deduplication to avoid duplicate edges.
+ * dfa_minimizer.cpp - implements DFA minimization with Hopcroft's partition refinement
+ * algorithm in O(k * n log n) for n states and k input symbols. It takes a DFA
+ * (represented by `dfaStates` and `dfaTransitions`) and reduces it to an equivalent
+ * minimal DFA by merging indistinguishable states. Key steps:
+ * - Initial partitioning of states by a caller-supplied label: for a single regex the label
+ * is whether the state's underlying NFA state set contains the original NFA's final state
+ * (`originalNFAEndId`); for the multi-rule lexer it is the winning token class of each
+ * accept state, so states accepting different tokens are never merged.
+ * - Indexed transition structure: the alphabet (distinct transition `CharSet`s) is numbered,
+ * the DFA becomes a dense state x symbol table completed with an implicit sink state, and
+ * inverse transitions are stored per symbol in compressed-sparse-row arrays.
+ * - Refinement: blocks live in a single element array (each block is a contiguous slice),
+ * and a splitter worklist drives the splits. For each splitter and symbol, predecessors are
+ * moved to the front of their block; touched blocks are split in place and the smaller half
+ * is queued (or both halves, if the block was already waiting), giving the n log n bound.
+ * - The sink keeps a label of its own, so missing transitions stay distinguishable from
+ * transitions into real states, exactly as in the original DFA.
+ * - After convergence, a minimized DFA is constructed where each block becomes a single state,
+ * preserving the original start state as state 0; the old -> new state mapping is returned
+ * so callers can carry per-state data (e.g. acceptance) over.
  * The implementation assumes: The input DFA uses `CharSet` as transition labels.
- * Acceptance is solely determined by inclusion of `originalNFAEndId` in the NFA state set.
  * The start state of the input DFA is `dfaStates[0]`.
  */
 #include "dfa.h"
 #include <map>
 #include <algorithm>
-#include <iostream>
 #include <vector>
 #include <set>
-#include <tuple>
+#include <iterator>
 
-// 辅助：获取某个状态在哪个分区
-int getPartitionId(int stateId, const std::vector<std::vector<int>>& partitions) {
-    for (size_t i = 0; i < partitions.size(); ++i) {
-        for (int state : partitions[i]) {
-            if (state == stateId) return static_cast<int>(i);
-        }
+namespace {
+
+// 可细化划分：所有块共享一个元素数组，每个块是其中的连续区间 [start, end)
+struct RefinablePartition {
+    std::vector<int> elems;
+    std::vector<int> pos;      // 状态在 elems 中的位置
+    std::vector<int> blockOf;  // 状态所在块
+    std::vector<int> start;
+    std::vector<int> end;
+    std::vector<int> marked;   // 每个块中已标记（移到块首）的元素个数
+
+    int size(int block) const { return end[block] - start[block]; }
+
+    int addBlock(int s, int e) {
+        start.push_back(s);
+        end.push_back(e);
+        marked.push_back(0);
+        return static_cast<int>(start.size()) - 1;
     }
-    return -1;
-}
 
-// 辅助：获取状态在给定输入下的目标状态ID，如果没有则返回 -1
-int getTargetState(int stateId, const CharSet& symbol, const std::vector<DFATransition>& transitions) {
-    for (const auto& t : transitions) {
-        if (t.fromStateId == stateId && t.transitionSymbol == symbol) {
-            return t.toStateId;
+    // 把状态移到所在块已标记区域的末尾
+    void mark(int state) {
+        int block = blockOf[state];
+        int target = start[block] + marked[block];
+        int other = elems[target];
+        int p = pos[state];
+        elems[p] = other;
+        pos[other] = p;
+        elems[target] = state;
+        pos[state] = target;
+        ++marked[block];
+    }
+
+    // 按标记拆分块，返回新块编号（新块总是较小的一半），未拆分时返回 -1
+    int split(int block) {
+        int m = marked[block];
+        marked[block] = 0;
+        if (m == size(block)) return -1;
+
+        int newBlock;
+        if (m <= size(block) - m) {
+            newBlock = addBlock(start[block], start[block] + m);
+            start[block] += m;
+        } else {
+            newBlock = addBlock(start[block] + m, end[block]);
+            end[block] = start[block] + m;
         }
+        for (int i = start[newBlock]; i < end[newBlock]; ++i) {
+            blockOf[elems[i]] = newBlock;
+        }
+        return newBlock;
     }
-    return -1;
-}
+};
 
-void minimizeDFA(const std::vector<DFAState>& dfaStates,
-                 const std::vector<DFATransition>& dfaTransitions,
-                 int originalNFAEndId,
-                 std::vector<DFAState>& minDfaStates,
-                 std::vector<DFATransition>& minDfaTransitions) {
-    
+} // namespace
+
+void minimizeDFAWithLabels(const std::vector<DFAState>& dfaStates,
+                           const std::vector<DFATransition>& dfaTransitions,
+                           const std::vector<int>& stateLabels,
+                           std::vector<DFAState>& minDfaStates,
+                           std::vector<DFATransition>& minDfaTransitions,
+                           std::vector<int>& stateMapping) {
+
+    minDfaStates.clear();
+    minDfaTransitions.clear();
+    stateMapping.clear();
     if (dfaStates.empty()) return;
 
+    const int n = static_cast<int>(dfaStates.size());
+    const int sink = n;          // 补全用的陷阱状态
+    const int total = n + 1;
+
     // 创建状态ID到索引的映射
     std::map<int, int> stateIdToIdx;
-    for (size_t i = 0; i < dfaStates.size(); ++i) {
+    for (int i = 0; i < n; ++i) {
         stateIdToIdx[dfaStates[i].id] = i;
     }
 
-    // 1. 初始划分：使用 vector<vector<int>> 存储分区
-    std::vector<std::vector<int>> partitions;
-    std::vector<int> nonAcceptingStates;
-    std::vector<int> acceptingStates;
-    
-    // 存储每个状态当前所在的分区编号
-    std::vector<int> stateGroup(dfaStates.size());
-    
-    for (const auto& s : dfaStates) {
-        if (s. nfaStates.count(originalNFAEndId)) {
-            acceptingStates.push_back(s.id);
-        } else {
-            nonAcceptingStates.push_back(s. id);
+    // 1. 字母表编号
+    std::map<CharSet, int> symbolIndex;
+    std::vector<CharSet> alphabet;
+    for (const auto& t : dfaTransitions) {
+        if (symbolIndex.emplace(t.transitionSymbol, static_cast<int>(alphabet.size())).second) {
+            alphabet.push_back(t.transitionSymbol);
         }
     }
-    
-    // 初始化分区和分组映射
-    if (! nonAcceptingStates.empty()) {
-        partitions.push_back(nonAcceptingStates);
-        for (int state : nonAcceptingStates) {
-            stateGroup[stateIdToIdx[state]] = 0;
+    const int k = static_cast<int>(alphabet.size());
+
+    // 2. 索引化转移表 delta[state * k + symbol]，缺失的转移指向 sink
+    std::vector<int> delta(static_cast<size_t>(total) * k, sink);
+    for (const auto& t : dfaTransitions) {
+        int from = stateIdToIdx[t.fromStateId];
+        int to = stateIdToIdx[t.toStateId];
+        delta[static_cast<size_t>(from) * k + symbolIndex[t.transitionSymbol]] = to;
+    }
+
+    // 3. 逆转移（CSR）：inverse[invStart[a * total + t] .. invStart[a * total + t + 1]) 为 t 的 a-前驱
+    std::vector<int> invStart(static_cast<size_t>(k) * total + 1, 0);
+    for (int s = 0; s < total; ++s) {
+        for (int a = 0; a < k; ++a) {
+            ++invStart[static_cast<size_t>(a) * total + delta[static_cast<size_t>(s) * k + a] + 1];
         }
     }
-    if (!acceptingStates.empty()) {
-        int grpIdx = partitions.size();
-        partitions.push_back(acceptingStates);
-        for (int state : acceptingStates) {
-            stateGroup[stateIdToIdx[state]] = grpIdx;
+    for (size_t i = 1; i < invStart.size(); ++i) {
+        invStart[i] += invStart[i - 1];
+    }
+    std::vector<int> inverse(invStart.back());
+    {
+        std::vector<int> fill(invStart.begin(), invStart.end() - 1);
+        for (int s = 0; s < total; ++s) {
+            for (int a = 0; a < k; ++a) {
+                inverse[fill[static_cast<size_t>(a) * total + delta[static_cast<size_t>(s) * k + a]]++] = s;
+            }
         }
     }
 
-    // 收集所有出现过的输入符号
-    std::vector<CharSet> alphabet;
-    for (const auto& t : dfaTransitions) {
-        bool exists = false;
-        for (const auto& a : alphabet) {
-            if (a == t.transitionSymbol) {
-                exists = true;
-                break;
-            }
+    // 4. 初始划分：标签相同的状态放入同一块，sink 单独一块
+    RefinablePartition P;
+    P.elems.reserve(total);
+    P.pos.resize(total);
+    P.blockOf.resize(total);
+
+    std::map<int, std::vector<int>> statesByLabel;
+    for (int i = 0; i < n; ++i) {
+        statesByLabel[stateLabels[i]].push_back(i);
+    }
+    auto appendBlock = [&P](const std::vector<int>& states) {
+        int s = static_cast<int>(P.elems.size());
+        for (int state : states) {
+            P.pos[state] = static_cast<int>(P.elems.size());
+            P.elems.push_back(state);
+        }
+        int block = P.addBlock(s, static_cast<int>(P.elems.size()));
+        for (int state : states) {
+            P.blockOf[state] = block;
         }
-        if (!exists) alphabet. push_back(t.transitionSymbol);
+    };
+    for (const auto& entry : statesByLabel) {
+        appendBlock(entry.second);
     }
+    appendBlock({sink});
 
-    // 2. 不断分割分区（分区细化算法）
-    bool changed = true;
-    while (changed) {
-        changed = false;
-        std::vector<std::vector<int>> newPartitions;
+    // 工作表：除最大块外的所有初始块
+    std::vector<int> worklist;
+    int largest = 0;
+    for (int b = 1; b < static_cast<int>(P.start.size()); ++b) {
+        if (P.size(b) > P.size(largest)) largest = b;
+    }
+    for (int b = 0; b < static_cast<int>(P.start.size()); ++b) {
+        if (b != largest) worklist.push_back(b);
+    }
 
-        // 对每个分区进行检查
-        for (size_t partIdx = 0; partIdx < partitions.size(); ++partIdx) {
-            const auto& partition = partitions[partIdx];
-            
-            if (partition.size() <= 1) {
-                newPartitions. push_back(partition);
-                continue;
-            }
+    // 5. 细化
+    std::vector<int> splitter;
+    std::vector<int> touched;
+    while (!worklist.empty()) {
+        int B = worklist.back();
+        worklist.pop_back();
+        splitter.assign(P.elems.begin() + P.start[B], P.elems.begin() + P.end[B]);
 
-            bool partitionSplit = false;
-            
-            // 对每个输入符号检查是否需要分割
-            for (const auto& symbol : alphabet) {
-                // 创建 transition signature -> states 的映射
-                // 使用 vector<int> 作为签名，每个符号对应一个转移目标分组
-                std::map<std::vector<int>, std::vector<int>> splitGroups;
-                
-                for (int stateId : partition) {
-                    std::vector<int> signature;
-                    
-                    // 对所有符号计算转移签名
-                    for (const auto& sym : alphabet) {
-                        int target = getTargetState(stateId, sym, dfaTransitions);
-                        int targetGroup = (target >= 0) ?  stateGroup[stateIdToIdx[target]] : -1;
-                        signature.push_back(targetGroup);
-                    }
-                    
-                    splitGroups[signature].push_back(stateId);
-                }
-                
-                // 如果分割出多个子组，则进行分割
-                if (splitGroups.size() > 1) {
-                    changed = true;
-                    partitionSplit = true;
-                    
-                    // 添加新分区
-                    for (auto& entry : splitGroups) {
-                        int newGrpIdx = newPartitions. size();
-                        newPartitions.push_back(entry.second);
-                        for (int state : entry.second) {
-                            stateGroup[stateIdToIdx[state]] = newGrpIdx;
-                        }
-                    }
-                    break; // 已分割，跳出符号循环
+        for (int a = 0; a < k; ++a) {
+            touched.clear();
+            for (int t : splitter) {
+                size_t key = static_cast<size_t>(a) * total + t;
+                for (int i = invStart[key]; i < invStart[key + 1]; ++i) {
+                    int s = inverse[i];
+                    int Y = P.blockOf[s];
+                    if (P.marked[Y] == 0) touched.push_back(Y);
+                    P.mark(s);
                 }
             }
-            
-            // 如果没有分割，保持原样
-            if (!partitionSplit) {
-                newPartitions.push_back(partition);
-            }
-        }
-        
-        if (changed) {
-            partitions = newPartitions;
-            // 更新 stateGroup 映射
-            for (size_t i = 0; i < partitions.size(); ++i) {
-                for (int state : partitions[i]) {
-                    stateGroup[stateIdToIdx[state]] = i;
-                }
+
+            for (int Y : touched) {
+                int Z = P.split(Y);
+                if (Z < 0) continue;
+                // Y 已在工作表中时两半都需处理；否则只需较小的一半，而 Z 总是较小的一半。
+                // 两种情况都只需把 Z 加入工作表
+                worklist.push_back(Z);
             }
         }
     }
 
-    // 3.  构建最小化后的 DFA
-    minDfaStates.clear();
-    minDfaTransitions.clear();
-
-    // 找到初始状态所在的分区
-    int oldStartId = dfaStates[0].id;
-    int startPartitionIdx = stateGroup[stateIdToIdx[oldStartId]];
-
-    // 创建分区索引到新状态ID的映射
-    std::map<int, int> partitionToNewId;
-    partitionToNewId[startPartitionIdx] = 0; // 初始状态分区映射到 ID 0
-    
-    int nextId = 1;
-    for (size_t i = 0; i < partitions.size(); ++i) {
-        if (static_cast<int>(i) != startPartitionIdx) {
-            partitionToNewId[i] = nextId++;
+    // 6. 构建最小化后的 DFA：按首次出现顺序编号，初始状态（索引 0）所在块编号为 0
+    std::vector<int> blockToNewId(P.start.size(), -1);
+    std::vector<int> representative;
+    for (int i = 0; i < n; ++i) {
+        int block = P.blockOf[i];
+        if (blockToNewId[block] < 0) {
+            blockToNewId[block] = static_cast<int>(representative.size());
+            representative.push_back(i);
         }
     }
 
-    // 创建旧状态ID到新状态ID的映射
-    std::map<int, int> oldToNewMap;
-    for (size_t i = 0; i < partitions.size(); ++i) {
-        int newId = partitionToNewId[i];
-        for (int oldId : partitions[i]) {
-            oldToNewMap[oldId] = newId;
-        }
+    minDfaStates.resize(representative.size());
+    for (size_t newId = 0; newId < representative.size(); ++newId) {
+        DFAState& newState = minDfaStates[newId];
+        newState.id = static_cast<int>(newId);
+        newState.stateName = std::to_string(newId);
     }
 
-    // 创建新状态（按新ID排序）
-    std::vector<std::pair<int, size_t>> idToPartitionIdx; // (newId, partitionIdx)
-    for (size_t i = 0; i < partitions.size(); ++i) {
-        idToPartitionIdx.push_back({partitionToNewId[i], i});
+    stateMapping.resize(n);
+    for (int i = 0; i < n; ++i) {
+        int newId = blockToNewId[P.blockOf[i]];
+        stateMapping[i] = newId;
+        // 合并后的状态对应所有被合并状态的 NFA 状态并集
+        const auto& oldStates = dfaStates[i].nfaStates;
+        auto& merged = minDfaStates[newId].nfaStates;
+        std::vector<int> unionStates;
+        std::set_union(merged.begin(), merged.end(), oldStates.begin(), oldStates.end(),
+                       std::back_inserter(unionStates));
+        merged = std::move(unionStates);
     }
-    std::sort(idToPartitionIdx.begin(), idToPartitionIdx.end());
 
-    // 构建新状态
-    for (const auto& pair : idToPartitionIdx) {
-        int newId = pair.first;
-        size_t partIdx = pair.second;
-        
-        DFAState newState;
-        newState.id = newId;
-        newState.stateName = std::to_string(newId);
-        
-        // 检查是否为接受状态
-        bool isAccepting = false;
-        for (int oldId : partitions[partIdx]) {
-            if (dfaStates[stateIdToIdx[oldId]].nfaStates.count(originalNFAEndId)) {
-                isAccepting = true;
-                break;
-            }
+    // 7. 创建新转移：取每块代表状态的出边
+    for (size_t newId = 0; newId < representative.size(); ++newId) {
+        int rep = representative[newId];
+        for (int a = 0; a < k; ++a) {
+            int target = delta[static_cast<size_t>(rep) * k + a];
+            if (target == sink) continue;
+            minDfaTransitions.push_back({static_cast<int>(newId), stateMapping[target], alphabet[a]});
         }
-        
-        if (isAccepting) {
-            newState.nfaStates. insert(originalNFAEndId);
-        }
-        
-        minDfaStates.push_back(newState);
     }
+}
 
-    // 4. 创建新转移
-    std::set<std::tuple<int, int, CharSet>> addedTransitions; // 去重
-    
-    for (size_t i = 0; i < partitions.size(); ++i) {
-        if (partitions[i].empty()) continue;
-        
-        // 取代表状态
-        int representative = partitions[i][0];
-        int fromNewId = oldToNewMap[representative];
-
-        // 遍历所有输入符号
-        for (const auto& symbol : alphabet) {
-            int oldTarget = getTargetState(representative, symbol, dfaTransitions);
-            if (oldTarget >= 0) {
-                int toNewId = oldToNewMap[oldTarget];
-                
-                // 去重检查
-                auto transKey = std::make_tuple(fromNewId, toNewId, symbol);
-                if (addedTransitions.find(transKey) == addedTransitions.end()) {
-                    minDfaTransitions.push_back({fromNewId, toNewId, symbol});
-                    addedTransitions. insert(transKey);
-                }
-            }
-        }
+void minimizeDFA(const std::vector<DFAState>& dfaStates,
+                 const std::vector<DFATransition>& dfaTransitions,
+                 int originalNFAEndId,
+                 std::vector<DFAState>& minDfaStates,
+                 std::vector<DFATransition>& minDfaTransitions) {
+    // 接受 / 非接受两类初始划分
+    std::vector<int> labels(dfaStates.size());
+    for (size_t i = 0; i < dfaStates.size(); ++i) {
+        labels[i] = dfaStates[i].contains(originalNFAEndId) ? 1 : 0;
     }
-}
\ No newline at end of file
+
+    std::vector<int> stateMapping;
+    minimizeDFAWithLabels(dfaStates, dfaTransitions, labels,
+                          minDfaStates, minDfaTransitions, stateMapping);
+}
@@ -0,0 +1,155 @@
+/*
+ * incremental_lexer.cpp - implements Lexer::relexSpans, re-lexing after a text edit with work
+ * proportional to the edit instead of the input. It features:
+ * - Restart point: a token's longest-match scan may read past its own end, so a token that
+ * ends before the edit can still change (rules "a" and "a"*"b" on "aaac" -> "aaab"). A
+ * token-start byte (lexer_table.h) kills every scan that reaches it after leaving the start
+ * state, so scans that begin before the last such byte before the edit end there, and that
+ * byte is itself a token start. Re-lexing from it is always correct. The input start serves
+ * when there is none, which is the fallback to a full re-lex.
+ * - Tighter restart: when that point is far from the edit, a bounded backward walk keeps the
+ * set of DFA states that survive every byte up to the edit; any position where it holds the
+ * start state may begin a token whose scan reaches the edit. If the set empties within
+ * kMaxAliveWalk bytes, lexing restarts at the last old token boundary before the earliest
+ * such position; otherwise at the token-start byte. Each step of the walk touches every row,
+ * so it is never run over more than kMaxAliveWalk bytes. Bytes before the edit are the same in
+ * both inputs, so both steps read the new one.
+ * - Resynchronisation: from the restart point tokens are lexed forward in the new input. Once
+ * a token starts after the edited bytes at a position that, shifted back by the edit's length
+ * change, was a token start before, the rest of the stream is the old one shifted: lexing from
+ * a token start is deterministic and the remaining input is unchanged.
+ * - Old boundaries: the span list holds emitted tokens only, so token starts are known at span
+ * starts and span ends (the next token, possibly a skipped one, starts there), plus the
+ * token-start bytes. Skipped tokens inside the re-lexed range are recomputed like any other.
+ * - Splicing: the replaced spans are swapped for the new ones and the tail is shifted, all in
+ * place; on a lexical error 'spans' is left unchanged and the error is the one tokenizeSpans
+ * would report.
+ */
+#include "lexer.h"
+#include <algorithm>
+#include <stdexcept>
+
+namespace {
+
+// 向前逐状态回溯的最大字节数：每一步要访问所有行，更远时直接从 token 起始字节重新分析
+constexpr size_t kMaxAliveWalk = 256;
+
+// edit 之前最后一个 token 起始字节的位置（没有时为 0，即输入开头）：更早开始的扫描都在此终止
+size_t lastTokenStartByte(const LexerTable& table, std::string_view input, size_t edit) {
+    for (size_t p = edit; p > 0; --p) {
+        if (table.tokenStartByte[static_cast<unsigned char>(input[p - 1])]) return p - 1;
+    }
+    return 0;
+}
+
+// 在 [floor, edit) 内从 edit 处向前：返回可能有扫描跨过 edit 的 token 起点中最靠前的位置
+// （至多为 edit 本身）；kMaxAliveWalk 步内存活集合未变空时返回 floor
+template <typename StateT>
+size_t earliestAffectedStart(const LexerTable& table, std::string_view input, size_t floor, size_t edit) {
+    const StateT* next = table.next<StateT>();
+    const size_t numClasses = static_cast<size_t>(table.numClasses);
+    const size_t numRows = static_cast<size_t>(table.numRows);
+
+    // alive[q]：从状态 q 读完 [p, edit) 后仍未进入死状态
+    std::vector<char> alive(numRows, 1), previous(numRows);
+    alive[LexerTable::kDeadRow] = 0;
+    size_t earliest = edit;
+    for (size_t p = edit; p > floor; --p) {
+        if (edit - p == kMaxAliveWalk) return floor;
+        previous.swap(alive);
+        const size_t byteClass = table.byteClass[static_cast<unsigned char>(input[p - 1])];
+        bool any = false;
+        for (size_t q = LexerTable::kStartRow; q < numRows; ++q) {
+            alive[q] = previous[next[q * numClasses + byteClass]];
+            any = any || alive[q];
+        }
+        if (!any) break;
+        if (alive[LexerTable::kStartRow]) earliest = p - 1;
+    }
+    return earliest;
+}
+
+} // namespace
+
+TokenSplice Lexer::relexSpans(std::string_view input, const TextEdit& edit,
+                              std::vector<TokenSpan>& spans) const {
+    if (!isBuilt_) {
+        throw std::runtime_error("Lexer not built. Call build() first.");
+    }
+    if (edit.offset > input.length() || edit.insertedLength > input.length() - edit.offset) {
+        throw std::runtime_error("Edit lies outside the input");
+    }
+
+    // floor 是确定的 token 起点，且更早开始的扫描都到不了编辑处；离编辑较远时再尝试收紧
+    const size_t floor = lastTokenStartByte(table_, input, edit.offset);
+    size_t affected = floor;
+    if (edit.offset - floor > kMaxAliveWalk) {
+        switch (table_.width) {
+            case StateWidth::U8:  affected = earliestAffectedStart<uint8_t>(table_, input, floor, edit.offset); break;
+            case StateWidth::U16: affected = earliestAffectedStart<uint16_t>(table_, input, floor, edit.offset); break;
+            case StateWidth::U32: affected = earliestAffectedStart<uint32_t>(table_, input, floor, edit.offset); break;
+        }
+    }
+
+    // 重新分析的起点：affected 之前最后一个已知的旧 token 边界（span 的起点或终点、floor）
+    auto first = std::partition_point(spans.begin(), spans.end(), [affected](const TokenSpan& span) {
+        return span.offset + span.length <= affected;
+    });
+    size_t restart = first == spans.begin() ? 0 : std::prev(first)->offset + std::prev(first)->length;
+    if (first != spans.end() && first->offset <= affected) {
+        restart = std::max(restart, first->offset);
+    }
+    restart = std::max(restart, floor);
+
+    // 在新输入中向后分析，直到 token 起点落在编辑之后且平移回去恰是旧 token 起点
+    const size_t editEnd = edit.offset + edit.insertedLength;
+    const size_t oldEditEnd = edit.offset + edit.removedLength;
+    std::vector<TokenSpan> tokens;
+    auto tail = first;
+    size_t pos = restart;
+    while (pos < input.length()) {
+        if (pos >= editEnd) {
+            const size_t oldPos = pos - editEnd + oldEditEnd;
+            while (tail != spans.end() && tail->offset < oldPos) ++tail;
+            bool boundary = (tail != spans.end() && tail->offset == oldPos) ||
+                            (tail != spans.begin() && std::prev(tail)->offset + std::prev(tail)->length == oldPos);
+            if (boundary) break;
+        }
+
+        int tokenClass = -1;
+        size_t end = pos;
+        switch (table_.width) {
+            case StateWidth::U8:  end = matchLongest<uint8_t>(table_, input.data(), input.length(), pos, tokenClass); break;
+            case StateWidth::U16: end = matchLongest<uint16_t>(table_, input.data(), input.length(), pos, tokenClass); break;
+            case StateWidth::U32: end = matchLongest<uint32_t>(table_, input.data(), input.length(), pos, tokenClass); break;
+        }
+        if (end == pos) {
+            throwLexicalError(input, pos);
+        }
+        TokenSpan span = makeTokenSpan(pos, end - pos, tokenClass);
+        if (applyTokenAction(span, input.substr(pos, end - pos))) {
+            tokens.push_back(span);
+        }
+        pos = end;
+    }
+    if (pos >= input.length()) {
+        tail = spans.end();
+    }
+
+    // 拼接：[first, tail) 换成新 token，之后的 span 按长度变化平移
+    TokenSplice splice;
+    splice.firstToken = static_cast<size_t>(first - spans.begin());
+    splice.removedTokens = static_cast<size_t>(tail - first);
+    splice.insertedTokens = tokens.size();
+    for (auto it = tail; it != spans.end(); ++it) {
+        it->offset = it->offset - oldEditEnd + editEnd;
+    }
+    size_t common = std::min(splice.removedTokens, splice.insertedTokens);
+    std::copy(tokens.begin(), tokens.begin() + common, first);
+    if (splice.insertedTokens > common) {
+        spans.insert(first + common, tokens.begin() + common, tokens.end());
+    } else {
+        spans.erase(first + common, tail);
+    }
+    return splice;
+}
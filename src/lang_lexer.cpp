@@ -0,0 +1,52 @@
+/*
+ * lang_lexer.cpp - instantiates the compile-time lang.l lexer, checks it with static_asserts while
+ * compiling (so a rule the constexpr pipeline cannot handle, or a mis-scan, breaks the build), and
+ * implements Lexer::createDefault on top of its tables.
+ */
+#include "lang_lexer.h"
+#include "lexer.h"
+#include <iterator>
+#include <string_view>
+
+namespace {
+
+constexpr int langTokenClass(std::string_view name) {
+    for (size_t i = 0; i < std::size(kLangRules); ++i) {
+        if (name == kLangRules[i].name) return static_cast<int>(i);
+    }
+    return -1;
+}
+
+// text 整体被识别为 name 类别的一个 token
+constexpr bool lexesAs(std::string_view text, std::string_view name) {
+    int tokenClass = -1;
+    size_t end = kLangLexer.matchLongest(text.data(), text.size(), 0, tokenClass);
+    return end == text.size() && tokenClass == langTokenClass(name);
+}
+
+// 输出的 token 数，有无法识别的输入时返回 -1
+constexpr int countTokens(std::string_view text) {
+    int count = 0;
+    size_t end = kLangLexer.forEachToken(text, [&count](size_t, size_t, int) { ++count; });
+    return end == text.size() ? count : -1;
+}
+
+static_assert(lexesAs("var", "TM_VAR"));
+static_assert(lexesAs("variable", "TM_IDENT"));
+static_assert(lexesAs("<=", "TM_LE"));
+static_assert(lexesAs("42", "TM_NAT"));
+static_assert(lexesAs("1.5e-3", "TM_FLOAT"));
+static_assert(lexesAs(".5", "TM_FLOAT"));
+static_assert(lexesAs("7E+2", "TM_FLOAT"));
+static_assert(countTokens("if (x) y = 1;\n") == 8);
+static_assert(countTokens("x # y") == -1);
+
+} // namespace
+
+Lexer Lexer::createDefault() {
+    std::vector<TokenClass> tokenClasses;
+    for (const auto& rule : kLangRules) {
+        tokenClasses.push_back({static_cast<int>(tokenClasses.size()), rule.name, rule.regex, rule.action});
+    }
+    return fromTable(kLangLexer.table(), tokenClasses);
+}
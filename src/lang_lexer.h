@@ -0,0 +1,14 @@
+/*
+ * lang_lexer.h - the compile-time lexer for the built-in lang.l rules (lang_rules.h).
+ * kLangLexer is a constexpr StaticLexer evaluated by the compiler: code that includes this header
+ * gets a fully inlined, dimension-specialised scanner with no construction at run time. Every
+ * translation unit that includes it pays the constant evaluation at compile time, so include it
+ * only where the inlined scanner is wanted; Lexer::createDefault (lang_lexer.cpp) wraps the same
+ * tables in a runtime Lexer for the other front-ends.
+ */
+#pragma once
+
+#include "lang_rules.h"
+#include "static_lexer.h"
+
+inline constexpr auto kLangLexer = makeStaticLexer<kLangRules>();
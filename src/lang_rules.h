@@ -0,0 +1,76 @@
+/*
+ * lang_rules.h - the built-in lang.l token rules as a constexpr table. It is the single source of
+ * truth for both Lexer::initializeDefaultTokenClasses (runtime construction) and the compile-time
+ * lexer in lang_lexer.h. Order is priority: earlier rules win ties between equally long matches.
+ */
+#pragma once
+
+#include "static_lexer.h"
+
+inline constexpr StaticRule kLangRules[] = {
+    // 注意：顺序决定优先级！关键字必须在标识符之前
+
+    // 关键字（具体的字符串优先级最高）
+    {"TM_VAR", "\"var\"", TokenAction::Emit},
+    {"TM_IF", "\"if\"", TokenAction::Emit},
+    {"TM_THEN", "\"then\"", TokenAction::Emit},
+    {"TM_ELSE", "\"else\"", TokenAction::Emit},
+    {"TM_WHILE", "\"while\"", TokenAction::Emit},
+    {"TM_DO", "\"do\"", TokenAction::Emit},
+    {"TM_FOR", "\"for\"", TokenAction::Emit},
+    {"TM_CONTINUE", "\"continue\"", TokenAction::Emit},
+    {"TM_BREAK", "\"break\"", TokenAction::Emit},
+    {"TM_RETURN", "\"return\"", TokenAction::Emit},
+    {"TM_FUNC", "\"func\"", TokenAction::Emit},
+    {"TM_PROC", "\"proc\"", TokenAction::Emit},
+
+    // 多字符运算符（长的优先，必须在单字符运算符之前）
+    {"TM_LE", "\"<=\"", TokenAction::Emit},
+    {"TM_GE", "\">=\"", TokenAction::Emit},
+    {"TM_EQ", "\"==\"", TokenAction::Emit},
+    {"TM_NE", "\"!=\"", TokenAction::Emit},
+    {"TM_AND", "\"&&\"", TokenAction::Emit},
+    {"TM_OR", "\"||\"", TokenAction::Emit},
+    {"TM_PLUSEQ", "\"+=\"", TokenAction::Emit},
+    {"TM_MINUSEQ", "\"-=\"", TokenAction::Emit},
+    {"TM_MULEQ", "\"*=\"", TokenAction::Emit},
+    {"TM_DIVEQ", "\"/=\"", TokenAction::Emit},
+
+    // 浮点数（必须在整数之前）
+    // 修正说明：移除了之前正则表达式中意外引入的空格
+    // 格式1: digits.digits[exponent]  -> [0-9]+"."[0-9]*...
+    // 格式2: .digits[exponent]        -> "."[0-9]+...
+    // 格式3: digits exponent          -> [0-9]+exponent...
+    {"TM_FLOAT",
+     "(([0-9]+\".\"[0-9]*((\"e\"|\"E\")(\"+\"|\"-\")?[0-9]+)?)|"
+     "(\".\"[0-9]+((\"e\"|\"E\")(\"+\"|\"-\")?[0-9]+)?)|"
+     "([0-9]+((\"e\"|\"E\")(\"+\"|\"-\")?[0-9]+)))",
+     TokenAction::Emit},
+
+    // 整数（使用字符类简化）
+    {"TM_NAT", "[0-9]+", TokenAction::Emit},
+
+    // 标识符
+    {"TM_IDENT", "([_A-Za-z][_A-Za-z0-9]*)", TokenAction::Emit},
+
+    // 单字符运算符
+    {"TM_SEMICOL", "\";\"", TokenAction::Emit},
+    {"TM_LEFT_PAREN", "\"(\"", TokenAction::Emit},
+    {"TM_RIGHT_PAREN", "\")\"", TokenAction::Emit},
+    {"TM_LEFT_BRACE", "\"{\"", TokenAction::Emit},
+    {"TM_RIGHT_BRACE", "\"}\"", TokenAction::Emit},
+    {"TM_PLUS", "\"+\"", TokenAction::Emit},
+    {"TM_MINUS", "\"-\"", TokenAction::Emit},
+    {"TM_MUL", "\"*\"", TokenAction::Emit},
+    {"TM_DIV", "\"/\"", TokenAction::Emit},
+    {"TM_MOD", "\"%\"", TokenAction::Emit},
+    {"TM_LT", "\"<\"", TokenAction::Emit},
+    {"TM_GT", "\">\"", TokenAction::Emit},
+    {"TM_ASGNOP", "\"=\"", TokenAction::Emit},
+    {"TM_NOT", "\"!\"", TokenAction::Emit},
+    {"TM_AMPERSAND", "\"&\"", TokenAction::Emit},
+    {"TM_COMMA", "\",\"", TokenAction::Emit},
+
+    // 空白字符
+    {"TM_BLANK", "(\" \"|\"\\t\"|\"\\n\"|\"\\r\")", TokenAction::Skip},
+};
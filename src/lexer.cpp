@@ -4,7 +4,8 @@
  * It features:
  * - Token class management: supports adding custom token classes or initializing
  * a predefined set (e.g., keywords, operators, identifiers, literals) with priority
- * determined by declaration order (earlier = higher priority).
+ * determined by declaration order (earlier = higher priority), or loading them from a
+ * plain-text rules file with one "NAME REGEX" pair per line.
  * - NFA construction: for each token regex, performs full preprocessing (including
  * string literal handling, character class parsing), simplifies syntactic sugar (?, +),
  * inserts explicit concatenation, converts to postfix, and builds an NFA via Thompson's construction.
@@ -12,9 +13,31 @@
  * epsilon transitions to each individual NFA start.
  * - DFA construction: converts the merged NFA to DFA using subset construction and caches
  * which token classes each DFA accepting state corresponds to (based on original NFA end states).
+ * - DFA minimization: merges equivalent states with an initial partition keyed by the winning
+ * token class of each accept state, so per-rule acceptance and priority are preserved.
+ * - Transition table: flattens the DFA into a row-major state x byte-class next-state table
+ * (byte classes come from the canonical inputs of subset construction, state ids are stored
+ * as uint8/uint16/uint32 depending on DFA size) plus a per-state accept array, so tokenization
+ * costs one indexed load per input byte. The table is encoded as a binary image (lexer_image.h)
+ * that 'save' writes out and 'load' memory-maps back without rebuilding.
+ * - Build cache: with a cache directory set, 'build' looks up the image by rule-set hash
+ * (lexer_cache.h) and memory-maps it on a hit; on a miss it builds and stores the image with an
+ * atomic rename, so concurrent builders never observe partial files.
  * - Lexical analysis: implements longest-match tokenization with backtracking to the last
- * accepting state, skips tokens of type 'TM_BLANK' (whitespace), provides detailed error
- * messages on unrecognized input, including expected symbols and current DFA state.
+ * accepting state, provides detailed error messages on unrecognized input, including
+ * expected symbols and current DFA state.
+ * - Token actions: each class is emitted, skipped (TM_BLANK by default), handed to a callback
+ * or only counted; actions are copied into the runtime table at build time, so the scanner
+ * never looks at class names.
+ * - Zero-copy output: 'tokenizeSpans' emits (offset, length, class id) spans into a reusable
+ * caller buffer; 'tokenize' is built on top of it and materializes lexemes, class names and
+ * line/column positions.
+ * - Thread safety: tokenization only reads the built tables and keeps all scan state on the
+ * stack or in caller buffers, so one built Lexer can be shared by any number of threads.
+ * - Build statistics: 'build' times every stage, records the automaton sizes (and, when enabled,
+ * the memory the build added at its peak, see PeakMemoryMeter) in the returned BuildStats, and
+ * sends progress messages through BUILD_LOG, which prints nothing unless the application
+ * installs a sink.
  * - DFA inspection: offers 'displayDFA' for debugging (shows accept states and transitions)
  * and 'generatorDotFile' to export the lexer DFA to Graphviz format, labeling accept states
  * with their primary token class name.
@@ -22,165 +45,217 @@
 #include "lexer.h"
 #include "regex_parser.h"
 #include "regex_simplifier.h"
+#include "lang_rules.h"
+#include "build_stats.h"
+#include "lexer_cache.h"
+#include "lexer_image.h"
+#include "mapped_file.h"
 #include <iostream>
 #include <queue>
 #include <algorithm>
 #include <cctype>
+#include <chrono>
 
 void Lexer::addTokenClass(const std::string& name, const std::string& regex) {
+    addTokenClass(name, regex, name == "TM_BLANK" ? TokenAction::Skip : TokenAction::Emit);
+}
+
+void Lexer::addTokenClass(const std::string& name, const std::string& regex, TokenAction action) {
     TokenClass tc;
     tc.id = tokenClasses_.size();
     tc.name = name;
     tc.regex = regex;
+    tc.action = action;
     tokenClasses_.push_back(tc);
+    tokenCallbacks_.emplace_back();
+}
+
+TokenClass& Lexer::findTokenClass(const std::string& name) {
+    for (auto& tc : tokenClasses_) {
+        if (tc.name == name) return tc;
+    }
+    throw std::runtime_error("Unknown token class '" + name + "'");
+}
+
+void Lexer::setTokenAction(const std::string& name, TokenAction action) {
+    if (isBuilt_) {
+        throw std::runtime_error("Token actions must be set before build()");
+    }
+    findTokenClass(name).action = action;
+}
+
+void Lexer::setTokenCallback(const std::string& name, TokenCallback callback) {
+    TokenClass& tc = findTokenClass(name);
+    // 构建之后只能为已是 Callback 的类别（如 load 读入的）挂接回调，动作本身不变
+    if (isBuilt_ && tc.action != TokenAction::Callback) {
+        throw std::runtime_error("Token actions must be set before build()");
+    }
+    tc.action = TokenAction::Callback;
+    tokenCallbacks_[tc.id] = std::move(callback);
 }
 
 /**
  * 初始化预定义的 Token 类型（基于 lang.l）
  */
 void Lexer::initializeDefaultTokenClasses() {
-    // 注意：顺序决定优先级！关键字必须在标识符之前
-    
-    // 关键字（具体的字符串优先级最高）
-    addTokenClass("TM_VAR", "\"var\"");
-    addTokenClass("TM_IF", "\"if\"");
-    addTokenClass("TM_THEN", "\"then\"");
-    addTokenClass("TM_ELSE", "\"else\"");
-    addTokenClass("TM_WHILE", "\"while\"");
-    addTokenClass("TM_DO", "\"do\"");
-    addTokenClass("TM_FOR", "\"for\"");
-    addTokenClass("TM_CONTINUE", "\"continue\"");
-    addTokenClass("TM_BREAK", "\"break\"");
-    addTokenClass("TM_RETURN", "\"return\"");
-    addTokenClass("TM_FUNC", "\"func\"");
-    addTokenClass("TM_PROC", "\"proc\"");
-    
-    // 多字符运算符（长的优先，必须在单字符运算符之前）
-    addTokenClass("TM_LE", "\"<=\"");
-    addTokenClass("TM_GE", "\">=\"");
-    addTokenClass("TM_EQ", "\"==\"");
-    addTokenClass("TM_NE", "\"!=\"");
-    addTokenClass("TM_AND", "\"&&\"");
-    addTokenClass("TM_OR", "\"||\"");
-    addTokenClass("TM_PLUSEQ", "\"+=\"");
-    addTokenClass("TM_MINUSEQ", "\"-=\"");
-    addTokenClass("TM_MULEQ", "\"*=\"");
-    addTokenClass("TM_DIVEQ", "\"/=\"");
-    
-    // 浮点数（必须在整数之前）
-    // 修正说明：移除了之前正则表达式中意外引入的空格
-    // 格式1: digits.digits[exponent]  -> [0-9]+"."[0-9]*...
-    // 格式2: .digits[exponent]        -> "."[0-9]+...
-    // 格式3: digits exponent          -> [0-9]+exponent...
-    addTokenClass("TM_FLOAT", 
-        "(([0-9]+\".\"[0-9]*((\"e\"|\"E\")(\"+\"|\"-\")?[0-9]+)?)|"
-        "(\".\"[0-9]+((\"e\"|\"E\")(\"+\"|\"-\")?[0-9]+)?)|"
-        "([0-9]+((\"e\"|\"E\")(\"+\"|\"-\")?[0-9]+)))");
+    // 规则表（含优先级顺序的说明）见 lang_rules.h，与编译期 lexer 共用
+    for (const auto& rule : kLangRules) {
+        addTokenClass(rule.name, rule.regex, rule.action);
+    }
+}
 
-    // 整数（使用字符类简化）
-    addTokenClass("TM_NAT", "[0-9]+");
-    
-    // 标识符
-    addTokenClass("TM_IDENT", "([_A-Za-z][_A-Za-z0-9]*)");
-    
-    // 单字符运算符
-    addTokenClass("TM_SEMICOL", "\";\"");
-    addTokenClass("TM_LEFT_PAREN", "\"(\"");
-    addTokenClass("TM_RIGHT_PAREN", "\")\"");
-    addTokenClass("TM_LEFT_BRACE", "\"{\"");
-    addTokenClass("TM_RIGHT_BRACE", "\"}\"");
-    addTokenClass("TM_PLUS", "\"+\"");
-    addTokenClass("TM_MINUS", "\"-\"");
-    addTokenClass("TM_MUL", "\"*\"");
-    addTokenClass("TM_DIV", "\"/\"");
-    addTokenClass("TM_MOD", "\"%\"");
-    addTokenClass("TM_LT", "\"<\"");
-    addTokenClass("TM_GT", "\">\"");
-    addTokenClass("TM_ASGNOP", "\"=\"");
-    addTokenClass("TM_NOT", "\"!\"");
-    addTokenClass("TM_AMPERSAND", "\"&\"");
-    addTokenClass("TM_COMMA", "\",\"");
-    
-    // 空白字符
-    addTokenClass("TM_BLANK", "(\" \"|\"\\t\"|\"\\n\"|\"\\r\")");
+void Lexer::loadTokenClassesFromFile(const std::string& filename) {
+    std::ifstream in(filename);
+    if (!in) {
+        throw std::runtime_error("Cannot open rules file '" + filename + "'");
+    }
+    
+    std::string line;
+    int lineNumber = 0;
+    while (std::getline(in, line)) {
+        ++lineNumber;
+        if (!line.empty() && line.back() == '\r') line.pop_back();
+        
+        size_t nameBegin = line.find_first_not_of(" \t");
+        if (nameBegin == std::string::npos || line[nameBegin] == '#') continue;
+        
+        TokenAction action = TokenAction::Emit;
+        if (line.compare(nameBegin, 6, "%skip ") == 0 || line.compare(nameBegin, 6, "%skip\t") == 0) {
+            action = TokenAction::Skip;
+            nameBegin = line.find_first_not_of(" \t", nameBegin + 5);
+        }
+        if (nameBegin == std::string::npos) {
+            throw std::runtime_error(filename + ":" + std::to_string(lineNumber) +
+                                     ": expected 'NAME REGEX'");
+        }
+        size_t nameEnd = line.find_first_of(" \t", nameBegin);
+        size_t regexBegin = nameEnd == std::string::npos ? nameEnd : line.find_first_not_of(" \t", nameEnd);
+        if (regexBegin == std::string::npos) {
+            throw std::runtime_error(filename + ":" + std::to_string(lineNumber) +
+                                     ": expected 'NAME REGEX'");
+        }
+        addTokenClass(line.substr(nameBegin, nameEnd - nameBegin), line.substr(regexBegin), action);
+    }
 }
 
-void Lexer::build() {
+BuildStats Lexer::build() {
+    using Clock = std::chrono::steady_clock;
+    auto seconds = [](Clock::time_point since) {
+        return std::chrono::duration<double>(Clock::now() - since).count();
+    };
+    const Clock::time_point buildStart = Clock::now();
+    const PeakMemoryMeter memory(measurePeakMemory_);
+    
     if (tokenClasses_.empty()) {
         throw std::runtime_error("No token classes defined");
     }
+    for (const auto& tc : tokenClasses_) {
+        if (tc.action == TokenAction::Callback && !tokenCallbacks_[tc.id]) {
+            throw std::runtime_error("Token class '" + tc.name + "' has no callback");
+        }
+    }
+    
+    BuildStats stats;
+    stats.tokenClasses = tokenClasses_.size();
+    auto finishStats = [&]() {
+        stats.byteClasses = static_cast<size_t>(table_.numClasses);
+        stats.stateIdBytes = static_cast<size_t>(table_.width);
+        stats.imageBytes = table_.imageSize;
+        stats.totalSeconds = seconds(buildStart);
+        stats.peakMemoryBytes = memory.peakBytes();
+    };
+    
+    const std::string cachePath = cacheDirectory_.empty() ? "" : lexerCachePath(cacheDirectory_, ruleHash());
+    if (!cachePath.empty()) {
+        Clock::time_point start = Clock::now();
+        if (loadFromCache(cachePath)) {
+            BUILD_LOG("Loaded from cache: " << cachePath);
+            stats.tableSeconds = seconds(start);
+            stats.fromCache = true;
+            finishStats();
+            isBuilt_ = true;
+            return stats;
+        }
+    }
     
-    std::cout << "\n=== Building Lexer ===" << std::endl;
-    std::cout << "Token Classes: " << tokenClasses_.size() << std::endl;
+    BUILD_LOG("\n=== Building Lexer ===");
+    dfaStates_.clear();
+    dfaTransitions_.clear();
+    BUILD_LOG("Token Classes: " << tokenClasses_.size());
     
-    // Step 1: 为每个 token class 构建 NFA
-    std::vector<NFAUnit> nfas;
+    // Step 1: 为每个 token class 构建 NFA（所有节点和边来自同一个 arena，ID 全局唯一）
+    NFAArena arena;
+    std::vector<NFAFragment> nfas;
     std::vector<int> endNodeIds;
     
     for (const auto& tc : tokenClasses_) {
-        std::cout << "  Processing [" << tc.id << "]: " << tc.name;
-        if (tc.regex.length() > 50) {
-            std::cout << " = " << tc.regex.substr(0, 47) << "..." << std::endl;
-        } else {
-            std::cout << " = " << tc.regex << std::endl;
-        }
+        BUILD_LOG("  Processing [" << tc.id << "]: " << tc.name << " = "
+                  << (tc.regex.length() > 50 ? tc.regex.substr(0, 47) + "..." : tc.regex));
         
         try {
             // 预处理正则表达式
+            Clock::time_point start = Clock::now();
             auto tokens = preprocessRegex(tc.regex);
+            stats.preprocessSeconds += seconds(start);
             
-            // 简化正则表达式
+            // 简化正则表达式并插入连接符
+            start = Clock::now();
             auto simplifiedTokens = simplifyRegex(tokens);
-            
-            // 插入连接符
             auto tokensWithConcat = insertConcatSymbols(simplifiedTokens);
+            stats.simplifySeconds += seconds(start);
             
             // 转换为后缀表达式
+            start = Clock::now();
             InfixToPostfix converter(tokensWithConcat);
             converter.convert();
             const auto& postfix = converter.getPostfix();
+            stats.postfixSeconds += seconds(start);
             
             // 构建 NFA
-            NFAUnit nfa = regexToNFA(postfix);
+            start = Clock::now();
+            NFAFragment nfa = regexToNFA(postfix, arena);
+            stats.thompsonSeconds += seconds(start);
+            endNodeIds.push_back(nfa.end);
             nfas.push_back(nfa);
-            endNodeIds.push_back(nfa.end->id);
             
         } catch (const std::exception& e) {
             throw std::runtime_error("Failed to build NFA for '" + tc.name + "': " + e.what());
         }
     }
     
-    // Step 2: 合并多个 NFA 为一个 NFA
-    auto mergedStart = std::make_shared<NodeImpl>(9999, "merged_start");
-    
-    NFAUnit mergedNFA;
-    mergedNFA.start = mergedStart;
-    mergedNFA.end = nullptr;
-    mergedNFA.edges = {};
-    
-    for (size_t i = 0; i < nfas.size(); ++i) {
-        CharSet epsilon;
-        epsilon.isEpsilon = true;
-        mergedNFA.edges.push_back({mergedStart, nfas[i].start, epsilon});
-        mergedNFA.edges.insert(mergedNFA.edges.end(), 
-                               nfas[i].edges.begin(), 
-                               nfas[i].edges.end());
+    // Step 2: 合并多个 NFA 为一个 NFA：新起点经 epsilon 边连到各 NFA 起点
+    Clock::time_point start = Clock::now();
+    int mergedStart = arena.createNode();
+    for (const auto& nfa : nfas) {
+        arena.addEdge(mergedStart, nfa.start, CharSet());
     }
+    stats.nfaNodes = static_cast<size_t>(arena.nodeCount());
+    NFAUnit mergedNFA = arena.release(mergedStart, -1);
+    stats.nfaEdges = mergedNFA.edges.size();
+    stats.thompsonSeconds += seconds(start);
     
-    std::cout << "\nMerged NFA: " << mergedNFA.edges.size() << " edges" << std::endl;
+    BUILD_LOG("\nMerged NFA: " << mergedNFA.edges.size() << " edges");
     
     // Step 3: NFA 转 DFA
-    buildDFAFromNFA(mergedNFA, dfaStates_, dfaTransitions_);
+    start = Clock::now();
+    std::vector<CharSet> canonicalInputs;
+    buildDFAFromNFA(mergedNFA, dfaStates_, dfaTransitions_, &canonicalInputs);
     
     // Step 4: 标记接受状态
     acceptStateToTokenClasses_.clear();
     
+    std::map<int, int> endNodeToTokenClass;
+    for (size_t i = 0; i < endNodeIds.size(); ++i) {
+        endNodeToTokenClass.emplace(endNodeIds[i], static_cast<int>(i));
+    }
+    
     for (const auto& dfaState : dfaStates_) {
         std::vector<int> matchedTokenClasses;
         
-        for (size_t i = 0; i < endNodeIds.size(); ++i) {
-            if (dfaState.nfaStates.count(endNodeIds[i])) {
-                matchedTokenClasses.push_back(i);
+        for (int nfaState : dfaState.nfaStates) {
+            auto it = endNodeToTokenClass.find(nfaState);
+            if (it != endNodeToTokenClass.end()) {
+                matchedTokenClasses.push_back(it->second);
             }
         }
         
@@ -189,98 +264,304 @@ void Lexer::build() {
             acceptStateToTokenClasses_[dfaState.id] = matchedTokenClasses;
         }
     }
+    stats.subsetSeconds = seconds(start);
+    stats.dfaStates = dfaStates_.size();
+    stats.dfaTransitions = dfaTransitions_.size();
+    stats.canonicalInputs = canonicalInputs.size();
     
-    std::cout << "DFA built: " << dfaStates_.size() << " states, " 
-              << dfaTransitions_.size() << " transitions" << std::endl;
-    std::cout << "Accept states: " << acceptStateToTokenClasses_.size() << std::endl;
+    BUILD_LOG("DFA built: " << dfaStates_.size() << " states, "
+              << dfaTransitions_.size() << " transitions");
     
+    // Step 4.5: 最小化 DFA，初始划分按接受状态的优先 token 类别区分
+    start = Clock::now();
+    minimizeLexerDFA();
+    stats.minimizeSeconds = seconds(start);
+    stats.minDfaStates = dfaStates_.size();
+    stats.minDfaTransitions = dfaTransitions_.size();
+    stats.acceptStates = acceptStateToTokenClasses_.size();
+    
+    BUILD_LOG("Minimized DFA: " << dfaStates_.size() << " states, "
+              << dfaTransitions_.size() << " transitions");
+    BUILD_LOG("Accept states: " << acceptStateToTokenClasses_.size());
+    
+    // Step 5: 生成稠密转移表
+    start = Clock::now();
+    buildTransitionTable(canonicalInputs);
+    stats.tableSeconds = seconds(start);
+    BUILD_LOG("Byte classes: " << table_.numClasses << ", state id width: "
+              << static_cast<int>(table_.width) << " byte(s)");
+    
+    if (!cachePath.empty()) {
+        storeInCache(cachePath);
+    }
     isBuilt_ = true;
+    finishStats();
+    return stats;
+}
+
+bool Lexer::loadFromCache(const std::string& path) {
+    // 缓存项缺失、损坏或与当前规则不符（哈希冲突）都按未命中处理，之后会被重新写入
+    try {
+        auto file = std::make_shared<MappedFile>(path);
+        LexerTable table;
+        std::vector<std::string_view> names, regexes;
+        bindLexerImage(file, file->data().data(), file->size(), table, names, regexes);
+        if (table.ruleHash != ruleHash() || names.size() != tokenClasses_.size()) {
+            return false;
+        }
+        for (const auto& tc : tokenClasses_) {
+            if (names[tc.id] != tc.name || regexes[tc.id] != tc.regex || table.classAction[tc.id] != tc.action) {
+                return false;
+            }
+        }
+        table_ = table;
+    } catch (const std::exception&) {
+        return false;
+    }
+    
+    dfaStates_.clear();
+    dfaTransitions_.clear();
+    acceptStateToTokenClasses_.clear();
+    return true;
+}
+
+void Lexer::storeInCache(const std::string& path) const {
+    try {
+        writeFileAtomically(path, table_.image, table_.imageSize);
+    } catch (const std::exception& e) {
+        BUILD_LOG("Cache not updated: " << e.what());
+    }
+}
+
+void Lexer::minimizeLexerDFA() {
+    std::vector<int> labels(dfaStates_.size(), -1);
+    for (size_t i = 0; i < dfaStates_.size(); ++i) {
+        auto it = acceptStateToTokenClasses_.find(dfaStates_[i].id);
+        if (it != acceptStateToTokenClasses_.end() && !it->second.empty()) {
+            labels[i] = it->second[0];
+        }
+    }
+    
+    std::vector<DFAState> minStates;
+    std::vector<DFATransition> minTransitions;
+    std::vector<int> stateMapping;
+    minimizeDFAWithLabels(dfaStates_, dfaTransitions_, labels,
+                          minStates, minTransitions, stateMapping);
+    
+    // 被合并的状态优先类别相同，取任一代表状态的类别列表
+    std::map<int, std::vector<int>> minAcceptStates;
+    for (size_t i = 0; i < dfaStates_.size(); ++i) {
+        auto it = acceptStateToTokenClasses_.find(dfaStates_[i].id);
+        if (it != acceptStateToTokenClasses_.end()) {
+            minAcceptStates.emplace(stateMapping[i], it->second);
+        }
+    }
+    
+    dfaStates_ = std::move(minStates);
+    dfaTransitions_ = std::move(minTransitions);
+    acceptStateToTokenClasses_ = std::move(minAcceptStates);
+}
+
+void Lexer::buildTransitionTable(const std::vector<CharSet>& canonicalInputs) {
+    LexerImageContents contents;
+    
+    // 字节等价类：每个 canonical input 一类，未被任何边覆盖的字节共用最后一类
+    bool hasUncovered = false;
+    std::array<bool, 256> covered{};
+    for (size_t k = 0; k < canonicalInputs.size(); ++k) {
+        for (const auto& r : canonicalInputs[k].ranges) {
+            for (int c = r.start; c <= r.end; ++c) {
+                contents.byteClass[static_cast<unsigned char>(c)] = static_cast<uint8_t>(k);
+                covered[static_cast<unsigned char>(c)] = true;
+            }
+        }
+    }
+    for (int b = 0; b < 256; ++b) {
+        if (!covered[b]) {
+            contents.byteClass[b] = static_cast<uint8_t>(canonicalInputs.size());
+            hasUncovered = true;
+        }
+    }
+    contents.numClasses = static_cast<int>(canonicalInputs.size()) + (hasUncovered ? 1 : 0);
+    
+    // 子集构造保证状态 ID 为 0..n-1 连续编号，第 s 个状态放在第 s+1 行
+    const size_t numClasses = static_cast<size_t>(contents.numClasses);
+    contents.numRows = static_cast<int>(dfaStates_.size()) + 1;
+    std::vector<uint32_t>& rows = contents.rows;
+    rows.assign(static_cast<size_t>(contents.numRows) * numClasses, LexerTable::kDeadRow);
+    
+    for (const auto& trans : dfaTransitions_) {
+        uint32_t* row = &rows[(static_cast<size_t>(trans.fromStateId) + 1) * numClasses];
+        for (const auto& r : trans.transitionSymbol.ranges) {
+            for (int c = r.start; c <= r.end; ++c) {
+                row[contents.byteClass[static_cast<unsigned char>(c)]] = static_cast<uint32_t>(trans.toStateId) + 1;
+            }
+        }
+    }
+    
+    // 只有初始状态有出边的等价类：这类字节不可能出现在 token 中间。
+    // 若初始状态可被转移再次进入（如 (ab)*），则它也可能处于 token 中间，此时不设同步字节
+    bool startReentered = std::find(rows.begin(), rows.end(), LexerTable::kStartRow) != rows.end();
+    for (int b = 0; b < 256 && !startReentered; ++b) {
+        size_t c = contents.byteClass[b];
+        bool startOnly = rows[LexerTable::kStartRow * numClasses + c] != LexerTable::kDeadRow;
+        for (size_t r = LexerTable::kStartRow + 1; startOnly && r < static_cast<size_t>(contents.numRows); ++r) {
+            startOnly = rows[r * numClasses + c] == LexerTable::kDeadRow;
+        }
+        contents.tokenStartByte[b] = startOnly;
+    }
+    
+    // 每个接受状态只保留优先级最高（声明最早）的 token 类别
+    contents.acceptClass.assign(contents.numRows, -1);
+    for (const auto& [stateId, tokenClassIds] : acceptStateToTokenClasses_) {
+        if (!tokenClassIds.empty()) {
+            contents.acceptClass[stateId + 1] = tokenClassIds[0];
+        }
+    }
+    
+    for (const auto& tc : tokenClasses_) {
+        contents.actions.push_back(tc.action);
+        contents.names.push_back(tc.name);
+        contents.regexes.push_back(tc.regex);
+    }
+    contents.ruleHash = ruleHash();
+    
+    // 构建结果与 load() 读入的文件使用同一种映像格式
+    auto image = encodeLexerImage(contents);
+    std::vector<std::string_view> names, regexes;
+    bindLexerImage(image, image->data(), image->size() * sizeof(uint64_t), table_, names, regexes);
 }
 
-int Lexer::getTokenClassForState(int stateId) const {
-    auto it = acceptStateToTokenClasses_.find(stateId);
-    if (it == acceptStateToTokenClasses_.end() || it->second.empty()) {
-        return -1;
+uint64_t Lexer::ruleHash() const {
+    // FNV-1a，覆盖每个类别的名称、正则与动作（顺序即优先级）
+    uint64_t hash = 1469598103934665603ull;
+    auto mix = [&hash](const void* data, size_t length) {
+        const unsigned char* bytes = static_cast<const unsigned char*>(data);
+        for (size_t i = 0; i < length; ++i) {
+            hash ^= bytes[i];
+            hash *= 1099511628211ull;
+        }
+    };
+    for (const auto& tc : tokenClasses_) {
+        mix(tc.name.c_str(), tc.name.size() + 1);
+        mix(tc.regex.c_str(), tc.regex.size() + 1);
+        mix(&tc.action, sizeof(tc.action));
     }
-    return it->second[0];
+    return hash;
 }
 
-std::vector<LexerToken> Lexer::tokenize(const std::string& input) {
+void Lexer::save(const std::string& filename) const {
     if (!isBuilt_) {
         throw std::runtime_error("Lexer not built. Call build() first.");
     }
+    std::ofstream out(filename, std::ios::binary | std::ios::trunc);
+    if (!out) {
+        throw std::runtime_error("Cannot open '" + filename + "' for writing");
+    }
+    out.write(static_cast<const char*>(table_.image), static_cast<std::streamsize>(table_.imageSize));
+    if (!out.flush()) {
+        throw std::runtime_error("Failed to write '" + filename + "'");
+    }
+}
+
+Lexer Lexer::load(const std::string& filename) {
+    auto file = std::make_shared<MappedFile>(filename);
+    Lexer lexer;
+    std::vector<std::string_view> names, regexes;
+    try {
+        bindLexerImage(file, file->data().data(), file->size(), lexer.table_, names, regexes);
+    } catch (const std::exception& e) {
+        throw std::runtime_error(filename + ": " + e.what());
+    }
+    
+    for (size_t i = 0; i < names.size(); ++i) {
+        lexer.addTokenClass(std::string(names[i]), std::string(regexes[i]), lexer.table_.classAction[i]);
+    }
+    lexer.isBuilt_ = true;
+    return lexer;
+}
+
+Lexer Lexer::fromTable(const LexerTable& table, const std::vector<TokenClass>& tokenClasses) {
+    if (table.numTokenClasses != static_cast<int>(tokenClasses.size())) {
+        throw std::runtime_error("Token classes do not match the transition table");
+    }
+    Lexer lexer;
+    for (const auto& tc : tokenClasses) {
+        lexer.addTokenClass(tc.name, tc.regex, tc.action);
+    }
+    
+    // 复制为映像，与 build() / load() 的结果形式相同
+    LexerImageContents contents = imageContentsOf(table);
+    for (const auto& tc : tokenClasses) {
+        contents.names.push_back(tc.name);
+        contents.regexes.push_back(tc.regex);
+    }
+    contents.ruleHash = lexer.ruleHash();
+    auto image = encodeLexerImage(contents);
+    std::vector<std::string_view> names, regexes;
+    bindLexerImage(image, image->data(), image->size() * sizeof(uint64_t), lexer.table_, names, regexes);
+    lexer.isBuilt_ = true;
+    return lexer;
+}
+
+std::vector<LexerToken> Lexer::tokenize(const std::string& input) const {
+    std::vector<TokenSpan> spans;
+    tokenizeSpans(input, spans);
     
     std::vector<LexerToken> tokens;
+    tokens.reserve(spans.size());
     size_t pos = 0;
     int line = 1, column = 1;
     
-    while (pos < input.length()) {
-        int currentState = 0;
-        int lastAcceptPos = -1;
-        int lastAcceptTokenClass = -1;
-        size_t i = pos;
-        int tempLine = line, tempColumn = column;
-        
-        while (i < input.length()) {
-            char c = input[i];
-            
-            int nextState = -1;
-            for (const auto& trans : dfaTransitions_) {
-                if (trans.fromStateId == currentState && trans.transitionSymbol.match(c)) {
-                    nextState = trans.toStateId;
-                    break;
-                }
-            }
-            
-            if (nextState == -1) {
-                break;
-            }
-            
-            currentState = nextState;
-            i++;
-            
-            int tokenClassId = getTokenClassForState(currentState);
-            if (tokenClassId >= 0) {
-                lastAcceptPos = i;
-                lastAcceptTokenClass = tokenClassId;
+    for (const auto& span : spans) {
+        // 推进行列号（包括被跳过的空白）
+        for (; pos < span.offset; ++pos) {
+            if (input[pos] == '\n') {
+                line++;
+                column = 1;
+            } else {
+                column++;
             }
         }
         
-        if (lastAcceptPos > static_cast<int>(pos)) {
-            std::string lexeme = input.substr(pos, lastAcceptPos - pos);
-            
-            if (tokenClasses_[lastAcceptTokenClass].name != "TM_BLANK") {
-                LexerToken token;
-                token.lexeme = lexeme;
-                token.tokenClassId = lastAcceptTokenClass;
-                token.tokenClassName = tokenClasses_[lastAcceptTokenClass].name;
-                token.line = line;
-                token.column = column;
-                tokens.push_back(token);
-            }
-            
-            for (size_t j = pos; j < static_cast<size_t>(lastAcceptPos); ++j) {
-                if (input[j] == '\n') {
-                    line++;
-                    column = 1;
-                } else {
-                    column++;
-                }
-            }
-            
-            pos = lastAcceptPos;
+        LexerToken token;
+        token.lexeme = input.substr(span.offset, span.length);
+        token.tokenClassId = span.tokenClassId;
+        token.tokenClassName = tokenClasses_[span.tokenClassId].name;
+        token.line = line;
+        token.column = column;
+        tokens.push_back(std::move(token));
+    }
+    
+    return tokens;
+}
+
+void Lexer::tokenizeSpans(std::string_view input, std::vector<TokenSpan>& out) const {
+    out.clear();
+    forEachToken(input, [&out](const TokenSpan& span) { out.push_back(span); });
+}
+
+void Lexer::throwLexicalError(std::string_view input, size_t pos) const {
+    // 行列号只在出错时计算
+    int line = 1, column = 1;
+    for (size_t j = 0; j < pos; ++j) {
+        if (input[j] == '\n') {
+            line++;
+            column = 1;
         } else {
-            std::string errorContext = input.substr(pos, std::min(size_t(20), input.length() - pos));
-            throw std::runtime_error(
-                "Lexical error at line " + std::to_string(line) + 
-                ", column " + std::to_string(column) + 
-                ": unexpected character '" + std::string(1, input[pos]) + "'\n" +
-                "Context: \"" + errorContext + "\""
-            );
+            column++;
         }
     }
     
-    return tokens;
+    throw std::runtime_error(lexicalErrorMessage(
+        line, column, input.substr(pos, std::min(size_t(20), input.length() - pos))));
+}
+
+std::string Lexer::lexicalErrorMessage(int line, int column, std::string_view context) {
+    return "Lexical error at line " + std::to_string(line) + 
+           ", column " + std::to_string(column) + 
+           ": unexpected character '" + std::string(1, context[0]) + "'\n" +
+           "Context: \"" + std::string(context) + "\"";
 }
 
 void Lexer::displayDFA() const {
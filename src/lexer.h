@@ -2,16 +2,31 @@
  * lexer.h - defines a lexical analyzer (lexer) that supports user-defined token classes
  * specified by regular expressions. It builds a unified DFA from multiple regular expressions
  * (one per token class) to perform efficient lexical analysis. It defines:
- * - TokenClass: represents a named token type with an associated regex pattern.
+ * - TokenClass: represents a named token type with an associated regex pattern and the action
+ * taken when it is recognised (emit, skip, callback or count-only).
  * - LexerToken: the output token produced during lexing, containing lexeme, token class info,
  * and position.
- * - Lexer: defines functions of the DFA construction and tokenization logic.
+ * - TokenSpan: a zero-copy token, i.e. (offset, length, class id) referring back into the
+ * input buffer; class names are looked up on demand.
+ * - TokenSpan scanners: 'tokenizeSpans' looks up each byte's class as it goes, while
+ * 'tokenizeSpansClassified' (classified_lexer.cpp) classifies input blocks with SIMD first.
+ * - TextEdit / TokenSplice: an edit of the input and the resulting change of the span list, for
+ * incremental re-lexing ('relexSpans', incremental_lexer.cpp).
+ * - Lexer: defines functions of the DFA construction and tokenization logic, including the
+ * non-allocating 'forEachToken' visitor entry point (a template, so it is defined here).
+ * 'build' reports what it did as a BuildStats value (build_stats.h) rather than printing it.
  */
 #pragma once
 
+#include "build_stats.h"
 #include "dfa.h"
 #include "nfa.h"
+#include "lexer_table.h"
+#include <cstdint>
+#include <functional>
+#include <stdexcept>
 #include <string>
+#include <string_view>
 #include <vector>
 #include <map>
 #include <fstream>
@@ -23,6 +38,7 @@ struct TokenClass {
     int id;
     std::string name;
     std::string regex;
+    TokenAction action = TokenAction::Emit;
 };
 
 /**
@@ -36,15 +52,79 @@ struct LexerToken {
     int column;
 };
 
+/**
+ * 零拷贝 Token：引用输入缓冲区中的区间 [offset, offset + length)
+ */
+struct TokenSpan {
+    size_t offset;
+    uint32_t length;
+    int32_t tokenClassId;
+};
+
+/**
+ * 构造 span：长度超出 uint32_t（单个 token 达到 4 GiB）时抛出异常，而不是截断为错误的区间
+ */
+inline TokenSpan makeTokenSpan(size_t offset, size_t length, int32_t tokenClassId) {
+    if (length > UINT32_MAX) {
+        throw std::runtime_error("Token at offset " + std::to_string(offset) + " is " +
+                                 std::to_string(length) + " bytes long; spans hold at most 4 GiB - 1");
+    }
+    return {offset, static_cast<uint32_t>(length), tokenClassId};
+}
+
+/**
+ * 按需产生的 Token 视图：lexeme 指向输入（或流式读取的缓冲区）内部，不拷贝
+ */
+struct TokenView {
+    std::string_view lexeme;
+    uint64_t offset;        // 在输入中的字节偏移
+    int tokenClassId;
+    int line;
+    int column;
+};
+
+/**
+ * 一次文本编辑：旧输入中 [offset, offset + removedLength) 被替换为 insertedLength 字节的新内容
+ */
+struct TextEdit {
+    size_t offset;
+    size_t removedLength;
+    size_t insertedLength;
+};
+
+/**
+ * 增量分析对 span 列表的修改：从 firstToken 起的 removedTokens 个旧 span 被替换为
+ * insertedTokens 个新 span，其后的 span 按编辑的长度变化平移
+ */
+struct TokenSplice {
+    size_t firstToken = 0;
+    size_t removedTokens = 0;
+    size_t insertedTokens = 0;
+};
+
+// TokenAction::Callback 类别的回调：span 为 token 的位置与类别，lexeme 为其内容
+using TokenCallback = std::function<void(const TokenSpan& span, std::string_view lexeme)>;
+
 /**
  * 词法分析器类
+ * build() 之后对象不再改变：所有 const 成员函数只读取构建结果，可在多个线程中
+ * 并发调用同一个 Lexer
  */
 class Lexer {
 public:
     /**
      * 添加自定义 Token 类型
+     * 未指定动作时默认输出；名为 TM_BLANK 的类别默认丢弃（兼容 lang.l 的约定）
      */
     void addTokenClass(const std::string& name, const std::string& regex);
+    void addTokenClass(const std::string& name, const std::string& regex, TokenAction action);
+    
+    /**
+     * 设置 Token 类型的动作 / 回调（设置回调即把动作改为 Callback），须在 build() 之前调用；
+     * 例外是 load() 读入的 Lexer：可为动作已是 Callback 的类别挂接回调，未挂接的回调 token 被丢弃
+     */
+    void setTokenAction(const std::string& name, TokenAction action);
+    void setTokenCallback(const std::string& name, TokenCallback callback);
     
     /**
      * 初始化预定义的 Token 类型（基于 lang.l）
@@ -52,14 +132,86 @@ public:
     void initializeDefaultTokenClasses();
     
     /**
-     * 构建统一 DFA
+     * 从规则文件加载 Token 类型：每行 "NAME REGEX"（名称后的其余部分均为正则），
+     * 行首加 "%skip " 表示丢弃该类 token；空行和以 '#' 开头的行被忽略；顺序即优先级
+     */
+    void loadTokenClassesFromFile(const std::string& filename);
+    
+    /**
+     * 构建统一 DFA，返回各阶段耗时与自动机规模；进度消息只发往 BUILD_LOG 的接收器（build_stats.h）
+     * 设置了缓存目录时先按 ruleHash() 查找已编译映像：命中则直接映射使用（不含 DFA 结构，
+     * 与 load() 相同，BuildStats::fromCache 为 true），未命中才构建并把映像写入缓存
+     */
+    BuildStats build();
+    
+    /**
+     * 构建缓存目录（见 lexer_cache.h），空串表示不使用缓存；须在 build() 之前设置
+     * 缓存不可用（无法创建、读取或写入）时只影响速度，不影响构建结果
+     */
+    void setCacheDirectory(const std::string& directory) { cacheDirectory_ = directory; }
+    
+    /**
+     * 是否在 build() 中测量 BuildStats::peakMemoryBytes（默认关闭）；须在 build() 之前设置
+     * 测量会重置整个进程的常驻内存高水位（见 PeakMemoryMeter），只应在独占进程的工具中开启
      */
-    void build();
+    void setMeasurePeakMemory(bool enabled) { measurePeakMemory_ = enabled; }
     
     /**
      * 词法分析
      */
-    std::vector<LexerToken> tokenize(const std::string& input);
+    std::vector<LexerToken> tokenize(const std::string& input) const;
+    
+    /**
+     * 零拷贝词法分析：结果写入调用者提供的缓冲区 out（先清空，保留容量以便复用），
+     * 每个 token 只记录在 input 中的位置与类别 ID
+     */
+    void tokenizeSpans(std::string_view input, std::vector<TokenSpan>& out) const;
+    
+    /**
+     * 预分类模式的 tokenizeSpans：先把输入按块（ByteClassifier::kBlockSize 字节）向量化地
+     * 转换为等价类编号，再让 DFA 在类别流上做最长匹配，结果（包括错误）与 tokenizeSpans 相同。
+     * 是否比逐字节查表快取决于规则集的等价类划分，见 lexer_bench 的 classified 行
+     */
+    void tokenizeSpansClassified(std::string_view input, std::vector<TokenSpan>& out) const;
+    
+    /**
+     * 不分配内存的词法分析：动作为 Emit 的 token 依次交给 onEmit(const TokenSpan&)，
+     * Callback 类别调用其回调，Skip 类别直接丢弃；classCounts 非空时（长度为类别数）
+     * 累加 CountOnly 类别的 token 数
+     */
+    template <typename EmitFn>
+    void forEachToken(std::string_view input, EmitFn&& onEmit, size_t* classCounts = nullptr) const;
+    
+    /**
+     * 单个大输入的并行词法分析：按块推测分析后拼接，结果（包括错误）与 tokenizeSpans 完全相同
+     * numThreads 为 0 时使用全部核心；每块至少 minChunkSize 字节，输入过小时退化为顺序分析
+     */
+    static constexpr size_t kMinParallelChunkSize = 256 * 1024;
+    void tokenizeSpansParallel(std::string_view input, std::vector<TokenSpan>& out,
+                               unsigned numThreads = 0,
+                               size_t minChunkSize = kMinParallelChunkSize) const;
+    
+    /**
+     * 增量词法分析：spans 是编辑前输入的 tokenizeSpans 结果，input 是编辑后的完整输入。
+     * 只从编辑之前最近的、不受编辑影响的 token 边界开始重新分析，直到与旧 token 流重新同步，
+     * 然后原地更新 spans，结果与对 input 调用 tokenizeSpans 相同。重新分析的起点不早于编辑前
+     * 最后一个 token 起始字节（见 LexerTable::tokenStartByte），因此分析量与编辑的影响范围
+     * 成正比（之后的 span 只做平移）；编辑前很远都没有这种字节时最多退化为从头分析。
+     * 重新分析范围内的 Callback 类别会再次调用回调。出现词法错误时抛出异常，spans 保持不变
+     */
+    TokenSplice relexSpans(std::string_view input, const TextEdit& edit, std::vector<TokenSpan>& spans) const;
+    
+    /**
+     * 取 span 对应的词素（指向 input 内部，不拷贝）
+     */
+    static std::string_view lexemeOf(std::string_view input, const TokenSpan& span) {
+        return input.substr(span.offset, span.length);
+    }
+    
+    /**
+     * 按类别 ID 查询 Token 类型名称
+     */
+    const std::string& getTokenClassName(int tokenClassId) const { return tokenClasses_[tokenClassId].name; }
     
     /**
      * 显示 DFA 信息
@@ -75,13 +227,148 @@ public:
      * 获取 Token 类型列表
      */
     const std::vector<TokenClass>& getTokenClasses() const { return tokenClasses_; }
+    
+    bool isBuilt() const { return isBuilt_; }
+    
+    /**
+     * 规则集的哈希（类别名称、正则与动作，按优先级顺序），同样写入已编译映像
+     */
+    uint64_t ruleHash() const;
+    
+    /**
+     * 把构建结果写成二进制映像文件（格式见 lexer_image.h）
+     */
+    void save(const std::string& filename) const;
+    
+    /**
+     * 内存映射 save() 写出的映像并直接在其上扫描，无需重新构建；格式、版本或字节序
+     * 不符以及文件被截断时抛出 std::runtime_error。读入的 Lexer 不含 DFA 结构，
+     * displayDFA / generateDotFile 没有内容
+     */
+    static Lexer load(const std::string& filename);
+    
+    /**
+     * 由现成的转移表（如编译期构建的 StaticLexer::table()）与对应的类别列表得到已构建的 Lexer；
+     * 表被复制为映像，之后与 build() 的结果没有区别
+     */
+    static Lexer fromTable(const LexerTable& table, const std::vector<TokenClass>& tokenClasses);
+    
+    /**
+     * 预定义（lang.l）规则的 Lexer，转移表在编译期构建（lang_lexer.h），不运行 build()
+     */
+    static Lexer createDefault();
+    
+    /**
+     * 自环加速与字节分类器使用的指令集（build / load 之后有效）。默认不做自环加速（它只在长标识符
+     * 一类输入上更快），字节分类器使用 CPU 支持的最高级别；传入 detectSimdLevel() 同时开启自环加速，
+     * SimdLevel::None 两者都退回逐字节查表。与 build 一样不可与扫描并发调用
+     */
+    void setSimdLevel(SimdLevel level) {
+        table_.selfLoops = buildSelfLoopTable(table_, level);
+        table_.classifier = buildByteClassifier(table_, level);
+    }
+    
+    /**
+     * 运行时转移表（build 之后有效），供流式等其他扫描前端使用
+     */
+    const LexerTable& getTable() const { return table_; }
+    
+    /**
+     * 类别的动作（build 之后有效）
+     */
+    TokenAction getTokenAction(int tokenClassId) const { return table_.classAction[tokenClassId]; }
+    
+    /**
+     * 供逐个产生 token 的前端使用：执行 span 所属类别的动作（Callback 类别调用回调），
+     * 返回该 token 是否应输出。这类前端没有计数缓冲区，CountOnly 与 Skip 相同
+     */
+    bool applyTokenAction(const TokenSpan& span, std::string_view lexeme) const {
+        switch (table_.classAction[span.tokenClassId]) {
+            case TokenAction::Emit:
+                return true;
+            case TokenAction::Callback:
+                if (tokenCallbacks_[span.tokenClassId]) tokenCallbacks_[span.tokenClassId](span, lexeme);
+                return false;
+            default:
+                return false;
+        }
+    }
+    
+    /**
+     * 词法错误信息：line/column 从 1 开始，context 为出错位置起的一段输入
+     */
+    static std::string lexicalErrorMessage(int line, int column, std::string_view context);
 
 private:
     std::vector<TokenClass> tokenClasses_;
+    std::vector<TokenCallback> tokenCallbacks_;   // 与 tokenClasses_ 一一对应
     std::vector<DFAState> dfaStates_;
     std::vector<DFATransition> dfaTransitions_;
     std::map<int, std::vector<int>> acceptStateToTokenClasses_;
     bool isBuilt_ = false;
+    std::string cacheDirectory_;
+    bool measurePeakMemory_ = false;
+    
+    // 运行时转移表：字节等价类 + 窄状态 ID，是二进制映像（构建结果或映射的文件）的视图
+    LexerTable table_;
+    
+    void minimizeLexerDFA();
+    void buildTransitionTable(const std::vector<CharSet>& canonicalInputs);
+    bool loadFromCache(const std::string& path);
+    void storeInCache(const std::string& path) const;
+    
+    TokenClass& findTokenClass(const std::string& name);
+    
+    template <typename StateT, typename EmitFn>
+    void forEachTokenWithTable(std::string_view input, EmitFn& onEmit, size_t* classCounts) const;
+    template <typename StateT>
+    void tokenizeSpansClassifiedWithTable(std::string_view input, std::vector<TokenSpan>& out) const;
+    template <typename StateT>
+    void tokenizeSpansParallelWithTable(std::string_view input, std::vector<TokenSpan>& out,
+                                        size_t numChunks) const;
+    
+    [[noreturn]] void throwLexicalError(std::string_view input, size_t pos) const;
+};
+
+template <typename EmitFn>
+void Lexer::forEachToken(std::string_view input, EmitFn&& onEmit, size_t* classCounts) const {
+    if (!isBuilt_) {
+        throw std::runtime_error("Lexer not built. Call build() first.");
+    }
+    
+    switch (table_.width) {
+        case StateWidth::U8:  forEachTokenWithTable<uint8_t>(input, onEmit, classCounts); break;
+        case StateWidth::U16: forEachTokenWithTable<uint16_t>(input, onEmit, classCounts); break;
+        case StateWidth::U32: forEachTokenWithTable<uint32_t>(input, onEmit, classCounts); break;
+    }
+}
+
+template <typename StateT, typename EmitFn>
+void Lexer::forEachTokenWithTable(std::string_view input, EmitFn& onEmit, size_t* classCounts) const {
+    const TokenAction* actions = table_.classAction;
+    size_t pos = 0;
     
-    int getTokenClassForState(int stateId) const;
-};
\ No newline at end of file
+    while (pos < input.length()) {
+        int tokenClass = -1;
+        size_t end = matchLongest<StateT>(table_, input.data(), input.length(), pos, tokenClass);
+        if (end == pos) {
+            throwLexicalError(input, pos);
+        }
+        
+        TokenSpan span = makeTokenSpan(pos, end - pos, tokenClass);
+        switch (actions[tokenClass]) {
+            case TokenAction::Emit:
+                onEmit(span);
+                break;
+            case TokenAction::Skip:
+                break;
+            case TokenAction::Callback:
+                if (tokenCallbacks_[tokenClass]) tokenCallbacks_[tokenClass](span, input.substr(pos, end - pos));
+                break;
+            case TokenAction::CountOnly:
+                if (classCounts) ++classCounts[tokenClass];
+                break;
+        }
+        pos = end;
+    }
+}
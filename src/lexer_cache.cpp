@@ -0,0 +1,53 @@
+/*
+ * lexer_cache.cpp - implements cache entry naming and the write-to-temporary-then-rename store
+ * used by the build cache. Temporary names combine a random number with the thread id, so
+ * writers in different processes and threads never share one.
+ */
+#include "lexer_cache.h"
+#include "lexer_image.h"
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <random>
+#include <stdexcept>
+#include <thread>
+
+namespace fs = std::filesystem;
+
+std::string lexerCachePath(const std::string& directory, uint64_t ruleHash) {
+    char name[64];
+    std::snprintf(name, sizeof(name), "%016llx-v%u-b%u.lexer",
+                  static_cast<unsigned long long>(ruleHash), kLexerImageVersion, kLexerBuilderRevision);
+    return (fs::path(directory) / name).string();
+}
+
+void writeFileAtomically(const std::string& path, const void* data, size_t size) {
+    fs::path target(path);
+    std::error_code error;
+    if (target.has_parent_path()) {
+        fs::create_directories(target.parent_path(), error);
+    }
+
+    std::random_device random;
+    char suffix[64];
+    std::snprintf(suffix, sizeof(suffix), ".tmp-%08x-%zx", static_cast<unsigned>(random()),
+                  std::hash<std::thread::id>()(std::this_thread::get_id()));
+    fs::path temporary = target;
+    temporary += suffix;
+
+    {
+        std::ofstream out(temporary, std::ios::binary | std::ios::trunc);
+        out.write(static_cast<const char*>(data), static_cast<std::streamsize>(size));
+        if (!out.flush()) {
+            out.close();
+            fs::remove(temporary, error);
+            throw std::runtime_error("Cannot write '" + temporary.string() + "'");
+        }
+    }
+    fs::rename(temporary, target, error);
+    if (error) {
+        fs::remove(temporary, error);
+        throw std::runtime_error("Cannot rename '" + temporary.string() + "' to '" + path + "'");
+    }
+}
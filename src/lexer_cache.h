@@ -0,0 +1,34 @@
+/*
+ * lexer_cache.h - declares the helpers behind the on-disk build cache of Lexer::build. It features:
+ * - Content addressing: a cache entry is a lexer image (lexer_image.h) named after the rule-set
+ * hash, the image format version and the builder revision, so any change to names, regexes,
+ * actions or their order, to the format, or to the tables the builder produces maps to a
+ * different file and stale entries are simply never looked up.
+ * - Safe concurrent writers: an entry is written to a uniquely named temporary file in the cache
+ * directory and then renamed over the final name, which is atomic; readers only ever see a
+ * missing or a complete file, and racing builders of the same rules just replace each other's
+ * identical result.
+ */
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+/**
+ * 构建器修订号：同一规则集由 Lexer::build 得到的表（子集构造、最小化、字节等价类编号、
+ * 动作与优先级的解析等）发生任何变化时都必须加一，即使映像格式不变；否则缓存会一直
+ * 提供旧代码构建的表。映像格式变化时改的是 kLexerImageVersion
+ */
+constexpr uint32_t kLexerBuilderRevision = 1;
+
+/**
+ * 规则哈希为 ruleHash 的缓存项路径：<directory>/<hash>-v<格式版本>-b<构建器修订号>.lexer
+ */
+std::string lexerCachePath(const std::string& directory, uint64_t ruleHash);
+
+/**
+ * 原子地写入 path（必要时创建所在目录）：先写同目录下的临时文件，再改名为 path
+ * 失败时删除临时文件并抛出 std::runtime_error
+ */
+void writeFileAtomically(const std::string& path, const void* data, size_t size);
@@ -0,0 +1,211 @@
+/*
+ * lexer_image.cpp - implements encoding of a built lexer into its binary image and binding a
+ * LexerTable to an image in place. Encoding lays the sections out back to back with 8-byte
+ * alignment; binding checks the header and all section bounds, then verifies that every byte
+ * class, next state, accept class and action is in range before exposing the arrays.
+ */
+#include "lexer_image.h"
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+namespace {
+
+const char kMagic[8] = {'C', 'S', 'L', 'E', 'X', 'I', 'M', 'G'};
+constexpr uint32_t kByteOrderMark = 0x01020304;
+constexpr uint32_t kSwappedByteOrderMark = 0x04030201;
+
+size_t align8(size_t n) {
+    return (n + 7) & ~static_cast<size_t>(7);
+}
+
+[[noreturn]] void throwInvalidImage(const std::string& reason) {
+    throw std::runtime_error("Invalid lexer image: " + reason);
+}
+
+template <typename StateT>
+void copyNarrowed(uint8_t* dst, const std::vector<uint32_t>& rows) {
+    std::vector<StateT> narrow(rows.begin(), rows.end());
+    std::memcpy(dst, narrow.data(), narrow.size() * sizeof(StateT));
+}
+
+template <typename StateT>
+bool nextStatesInRange(const void* next, size_t count, uint32_t numRows) {
+    const StateT* states = static_cast<const StateT*>(next);
+    for (size_t i = 0; i < count; ++i) {
+        if (states[i] >= numRows) return false;
+    }
+    return true;
+}
+
+} // namespace
+
+LexerImageContents imageContentsOf(const LexerTable& table) {
+    LexerImageContents contents;
+    std::copy(table.byteClass, table.byteClass + 256, contents.byteClass.begin());
+    std::copy(table.tokenStartByte, table.tokenStartByte + 256, contents.tokenStartByte.begin());
+    contents.numClasses = table.numClasses;
+    contents.numRows = table.numRows;
+    const size_t numCells = static_cast<size_t>(table.numRows) * table.numClasses;
+    switch (table.width) {
+        case StateWidth::U8:  contents.rows.assign(table.next<uint8_t>(), table.next<uint8_t>() + numCells); break;
+        case StateWidth::U16: contents.rows.assign(table.next<uint16_t>(), table.next<uint16_t>() + numCells); break;
+        case StateWidth::U32: contents.rows.assign(table.next<uint32_t>(), table.next<uint32_t>() + numCells); break;
+    }
+    contents.acceptClass.assign(table.acceptClass, table.acceptClass + table.numRows);
+    contents.actions.assign(table.classAction, table.classAction + table.numTokenClasses);
+    return contents;
+}
+
+std::shared_ptr<const std::vector<uint64_t>> encodeLexerImage(const LexerImageContents& contents) {
+    const StateWidth width = LexerTable::widthFor(contents.numRows);
+    const size_t numTokenClasses = contents.names.size();
+
+    // 字符串区：name0 regex0 name1 regex1 ...
+    std::string strings;
+    std::vector<uint32_t> stringOffsets{0};
+    for (size_t i = 0; i < numTokenClasses; ++i) {
+        strings += contents.names[i];
+        stringOffsets.push_back(static_cast<uint32_t>(strings.size()));
+        strings += contents.regexes[i];
+        stringOffsets.push_back(static_cast<uint32_t>(strings.size()));
+    }
+
+    LexerImageHeader header{};
+    std::memcpy(header.magic, kMagic, sizeof(kMagic));
+    header.version = kLexerImageVersion;
+    header.byteOrderMark = kByteOrderMark;
+    header.ruleHash = contents.ruleHash;
+    header.numClasses = static_cast<uint32_t>(contents.numClasses);
+    header.numRows = static_cast<uint32_t>(contents.numRows);
+    header.numTokenClasses = static_cast<uint32_t>(numTokenClasses);
+    header.stateWidth = static_cast<uint32_t>(width);
+
+    size_t offset = align8(sizeof(LexerImageHeader));
+    auto place = [&offset](size_t bytes) {
+        size_t at = offset;
+        offset = align8(offset + bytes);
+        return static_cast<uint64_t>(at);
+    };
+    header.byteClassOffset = place(256);
+    header.tokenStartOffset = place(256);
+    header.nextOffset = place(contents.rows.size() * static_cast<size_t>(width));
+    header.acceptOffset = place(contents.acceptClass.size() * sizeof(int32_t));
+    header.actionOffset = place(numTokenClasses * sizeof(TokenAction));
+    header.stringOffsetsOffset = place(stringOffsets.size() * sizeof(uint32_t));
+    header.stringsOffset = place(strings.size());
+    header.imageSize = offset;
+
+    auto image = std::make_shared<std::vector<uint64_t>>(offset / sizeof(uint64_t), 0);
+    uint8_t* base = reinterpret_cast<uint8_t*>(image->data());
+    std::memcpy(base, &header, sizeof(header));
+    std::memcpy(base + header.byteClassOffset, contents.byteClass.data(), 256);
+    std::memcpy(base + header.tokenStartOffset, contents.tokenStartByte.data(), 256);
+    switch (width) {
+        case StateWidth::U8:  copyNarrowed<uint8_t>(base + header.nextOffset, contents.rows); break;
+        case StateWidth::U16: copyNarrowed<uint16_t>(base + header.nextOffset, contents.rows); break;
+        case StateWidth::U32: copyNarrowed<uint32_t>(base + header.nextOffset, contents.rows); break;
+    }
+    std::memcpy(base + header.acceptOffset, contents.acceptClass.data(),
+                contents.acceptClass.size() * sizeof(int32_t));
+    std::memcpy(base + header.actionOffset, contents.actions.data(),
+                numTokenClasses * sizeof(TokenAction));
+    std::memcpy(base + header.stringOffsetsOffset, stringOffsets.data(),
+                stringOffsets.size() * sizeof(uint32_t));
+    std::memcpy(base + header.stringsOffset, strings.data(), strings.size());
+    return image;
+}
+
+void bindLexerImage(std::shared_ptr<const void> storage, const void* data, size_t size,
+                    LexerTable& table, std::vector<std::string_view>& names,
+                    std::vector<std::string_view>& regexes) {
+    // 1. 头部
+    if (size < sizeof(LexerImageHeader)) throwInvalidImage("file too small");
+    if (reinterpret_cast<uintptr_t>(data) % alignof(uint64_t) != 0) throwInvalidImage("misaligned data");
+
+    LexerImageHeader header;
+    std::memcpy(&header, data, sizeof(header));
+    if (std::memcmp(header.magic, kMagic, sizeof(kMagic)) != 0) throwInvalidImage("bad magic");
+    if (header.byteOrderMark == kSwappedByteOrderMark) throwInvalidImage("written with a different byte order");
+    if (header.byteOrderMark != kByteOrderMark) throwInvalidImage("bad byte order mark");
+    if (header.version != kLexerImageVersion) {
+        throwInvalidImage("unsupported version " + std::to_string(header.version) +
+                          " (expected " + std::to_string(kLexerImageVersion) + ")");
+    }
+    if (header.imageSize > size) throwInvalidImage("truncated");
+    if (header.stateWidth != 1 && header.stateWidth != 2 && header.stateWidth != 4) {
+        throwInvalidImage("bad state width");
+    }
+    if (header.numClasses == 0 || header.numClasses > 256 || header.numRows < 2 ||
+        header.numRows > 0x7fffffffu || header.numTokenClasses == 0) {
+        throwInvalidImage("bad table dimensions");
+    }
+    if (header.numRows > (1ull << (8 * header.stateWidth))) throwInvalidImage("state width too narrow");
+
+    // 2. 各区段边界
+    const uint8_t* base = static_cast<const uint8_t*>(data);
+    auto section = [&](uint64_t offset, uint64_t bytes) {
+        if (offset % 8 != 0 || offset > header.imageSize || bytes > header.imageSize - offset) {
+            throwInvalidImage("section out of bounds");
+        }
+        return base + offset;
+    };
+    const uint64_t numCells = static_cast<uint64_t>(header.numRows) * header.numClasses;
+    const uint64_t numStrings = 2ull * header.numTokenClasses + 1;
+    const uint8_t* byteClass = section(header.byteClassOffset, 256);
+    const uint8_t* tokenStart = section(header.tokenStartOffset, 256);
+    const uint8_t* next = section(header.nextOffset, numCells * header.stateWidth);
+    const uint8_t* accept = section(header.acceptOffset, header.numRows * sizeof(int32_t));
+    const uint8_t* actions = section(header.actionOffset, header.numTokenClasses * sizeof(TokenAction));
+    const uint8_t* stringOffsetBytes = section(header.stringOffsetsOffset, numStrings * sizeof(uint32_t));
+    const uint32_t* stringOffsets = reinterpret_cast<const uint32_t*>(stringOffsetBytes);
+    const char* strings = reinterpret_cast<const char*>(section(header.stringsOffset, stringOffsets[numStrings - 1]));
+
+    // 3. 表项取值范围
+    for (int b = 0; b < 256; ++b) {
+        if (byteClass[b] >= header.numClasses || tokenStart[b] > 1) throwInvalidImage("bad byte class");
+    }
+    bool nextValid = false;
+    switch (header.stateWidth) {
+        case 1: nextValid = nextStatesInRange<uint8_t>(next, numCells, header.numRows); break;
+        case 2: nextValid = nextStatesInRange<uint16_t>(next, numCells, header.numRows); break;
+        case 4: nextValid = nextStatesInRange<uint32_t>(next, numCells, header.numRows); break;
+    }
+    if (!nextValid) throwInvalidImage("next state out of range");
+    const int32_t* acceptClass = reinterpret_cast<const int32_t*>(accept);
+    for (uint32_t r = 0; r < header.numRows; ++r) {
+        if (acceptClass[r] < -1 || acceptClass[r] >= static_cast<int32_t>(header.numTokenClasses)) {
+            throwInvalidImage("accept class out of range");
+        }
+    }
+    for (uint32_t i = 0; i < header.numTokenClasses; ++i) {
+        if (actions[i] > static_cast<uint8_t>(TokenAction::CountOnly)) throwInvalidImage("bad token action");
+    }
+    for (uint64_t i = 0; i + 1 < numStrings; ++i) {
+        if (stringOffsets[i] > stringOffsets[i + 1]) throwInvalidImage("bad string table");
+    }
+
+    // 4. 建立视图
+    table.byteClass = byteClass;
+    table.numClasses = static_cast<int>(header.numClasses);
+    table.numRows = static_cast<int>(header.numRows);
+    table.numTokenClasses = static_cast<int>(header.numTokenClasses);
+    table.width = static_cast<StateWidth>(header.stateWidth);
+    table.nextStates = next;
+    table.acceptClass = acceptClass;
+    table.classAction = reinterpret_cast<const TokenAction*>(actions);
+    table.tokenStartByte = tokenStart;
+    table.ruleHash = header.ruleHash;
+    table.storage = std::move(storage);
+    table.image = data;
+    table.imageSize = header.imageSize;
+    table.selfLoops = nullptr;                      // 自环加速默认关闭：只在长标识符一类输入上更快
+    table.classifier = buildByteClassifier(table);  // 由表推导，不存入映像
+
+    names.clear();
+    regexes.clear();
+    for (uint32_t i = 0; i < header.numTokenClasses; ++i) {
+        names.emplace_back(strings + stringOffsets[2 * i], stringOffsets[2 * i + 1] - stringOffsets[2 * i]);
+        regexes.emplace_back(strings + stringOffsets[2 * i + 1], stringOffsets[2 * i + 2] - stringOffsets[2 * i + 1]);
+    }
+}
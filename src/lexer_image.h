@@ -0,0 +1,75 @@
+/*
+ * lexer_image.h - defines the versioned binary image of a built lexer, the single storage
+ * format behind LexerTable. The same bytes live in memory after build(), are written by
+ * Lexer::save and are memory-mapped by Lexer::load. It features:
+ * - A fixed header: magic "CSLEXIMG", format version, byte-order mark, total size, rule-set
+ * hash, table dimensions and the offset of every section.
+ * - 8-byte aligned sections read in place: byte classes, token-start bytes, the next-state
+ * table at its narrow width, per-row accept classes, per-class actions, and the class names
+ * and regexes as an offset table plus one string blob.
+ * - Binding validates the header, every section bound and every table entry before the
+ * scanner may use it, so a truncated or foreign file is rejected instead of read out of bounds.
+ */
+#pragma once
+
+#include "lexer_table.h"
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+constexpr uint32_t kLexerImageVersion = 1;
+
+struct LexerImageHeader {
+    char magic[8];              // "CSLEXIMG"
+    uint32_t version;
+    uint32_t byteOrderMark;     // 0x01020304，按写入方的字节序存放
+    uint64_t imageSize;
+    uint64_t ruleHash;
+    uint32_t numClasses;
+    uint32_t numRows;
+    uint32_t numTokenClasses;
+    uint32_t stateWidth;        // 1 / 2 / 4
+    uint64_t byteClassOffset;
+    uint64_t tokenStartOffset;
+    uint64_t nextOffset;
+    uint64_t acceptOffset;
+    uint64_t actionOffset;
+    uint64_t stringOffsetsOffset;   // 2 * numTokenClasses + 1 个 uint32：名称与正则在字符串区中的边界
+    uint64_t stringsOffset;
+};
+
+// 编码前的构建结果
+struct LexerImageContents {
+    std::array<uint8_t, 256> byteClass{};
+    std::array<uint8_t, 256> tokenStartByte{};
+    int numClasses = 0;
+    int numRows = 0;
+    std::vector<uint32_t> rows;             // 行优先的下一状态表，编码时收窄到最窄宽度
+    std::vector<int32_t> acceptClass;       // 每行
+    std::vector<TokenAction> actions;       // 每个 token 类别
+    std::vector<std::string> names;
+    std::vector<std::string> regexes;
+    uint64_t ruleHash = 0;
+};
+
+/**
+ * 从已有的转移表取出编码所需的表数据（名称、正则与规则哈希由调用者补充）
+ */
+LexerImageContents imageContentsOf(const LexerTable& table);
+
+/**
+ * 编码为映像；以 uint64_t 为单位存放以保证 8 字节对齐，实际字节数见 header 的 imageSize
+ */
+std::shared_ptr<const std::vector<uint64_t>> encodeLexerImage(const LexerImageContents& contents);
+
+/**
+ * 校验 data 处的映像并让 table 成为它的视图（不复制），storage 负责在 table 存活期间保持内存有效
+ * names / regexes 为映像内字符串的视图；映像无效时抛出 std::runtime_error
+ */
+void bindLexerImage(std::shared_ptr<const void> storage, const void* data, size_t size,
+                    LexerTable& table, std::vector<std::string_view>& names,
+                    std::vector<std::string_view>& regexes);
@@ -0,0 +1,155 @@
+/*
+ * lexer_table.h - defines the compact runtime form of a built lexer DFA and the
+ * template-specialized longest-match scanner that runs over it. It features:
+ * - Byte equivalence classes: a 256-entry byte -> class map derived from the disjoint
+ * canonical inputs of subset construction, so each table row has one column per class
+ * instead of one per byte.
+ * - Narrow state ids: the row-major next-state table stores ids as uint8/uint16/uint32,
+ * chosen by DFA size, keeping small lexers entirely inside L1.
+ * - Row 0 is a dead state, so "no transition" is a zero test; DFA state s lives in row s + 1.
+ * - Accept data: each row stores its winning token class, and each class its resolved action
+ * (emit, skip, callback, count-only), so the scanner decides what to do with a token by two
+ * array loads instead of comparing class names.
+ * - Views over one image: the table only points into a contiguous, versioned image that is
+ * either produced by build() or memory-mapped from a compiled lexer file, so loading a
+ * compiled lexer needs no parsing or copying.
+ * - Token-start bytes: bytes whose only transition leaves the start state always begin a
+ * token, which gives parallel lexing safe places to start a chunk.
+ * - advanceMatch / matchLongest: the hot loop, instantiated once per state id width. The
+ * cursor form can be suspended at the end of an input chunk and resumed on the next one.
+ * With a self-loop table installed (Lexer::setSimdLevel), a state that has looped for
+ * SelfLoopTable::kInlineRun steps skips the rest of its run with SIMD compares (self_loop.h)
+ * instead of one table step per byte.
+ * - Class-stream scanning: a ByteClassifier (byte_classifier.h) bound with the table turns input
+ * blocks into class ids ahead of the DFA, for the pre-classified scanner mode.
+ */
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include "byte_classifier.h"
+#include "self_loop.h"
+
+// 识别出一个 token 后的动作
+enum class TokenAction : uint8_t {
+    Emit,       // 输出
+    Skip,       // 丢弃（如空白、注释）
+    Callback,   // 交给该类别注册的回调，不输出
+    CountOnly   // 只计数，不输出
+};
+
+// 状态 ID 的存储宽度
+enum class StateWidth : uint8_t {
+    U8 = 1,
+    U16 = 2,
+    U32 = 4
+};
+
+/**
+ * 运行时转移表：所有数组都是指向一块连续映像（见 lexer_image.h）的视图，
+ * 映像可以是 build() 生成的内存块，也可以是 mmap 映射的编译结果文件；
+ * storage 保持底层内存存活，复制 LexerTable 只共享同一映像
+ */
+struct LexerTable {
+    static constexpr uint32_t kDeadRow = 0;
+    static constexpr uint32_t kStartRow = 1;
+
+    const uint8_t* byteClass = nullptr;       // 256 项：字节 -> 等价类编号
+    int numClasses = 0;                       // 等价类个数（每行列数）
+    int numRows = 0;                          // 行数（DFA 状态数 + 死状态）
+    int numTokenClasses = 0;
+    StateWidth width = StateWidth::U32;
+
+    // 行优先的下一状态表，元素类型由 width 决定
+    const void* nextStates = nullptr;
+
+    // 每行的优先 token 类别，-1 表示非接受状态
+    const int32_t* acceptClass = nullptr;
+
+    // 每个 token 类别的动作（build 时确定），按 acceptClass 给出的类别索引
+    const TokenAction* classAction = nullptr;
+
+    // 256 项：只能从初始状态读入的字节为 1。输入中这样的字节必然是某个 token 的第一个字节，
+    // 可作为并行分析的同步点
+    const uint8_t* tokenStartByte = nullptr;
+
+    uint64_t ruleHash = 0;                    // 生成该表的规则集的哈希
+
+    // 底层映像
+    std::shared_ptr<const void> storage;
+    const void* image = nullptr;
+    size_t imageSize = 0;
+
+    // 自环状态的向量化扫描数据（不属于映像，默认不生成，由 Lexer::setSimdLevel 开启）；为空时逐字节查表
+    std::shared_ptr<const SelfLoopTable> selfLoops;
+
+    // 类别流扫描器使用的向量化字节分类器（同样在绑定映像时生成）
+    std::shared_ptr<const ByteClassifier> classifier;
+
+    template <typename StateT>
+    const StateT* next() const { return static_cast<const StateT*>(nextStates); }
+
+    // 根据 DFA 状态数选择最窄的状态 ID 宽度
+    static StateWidth widthFor(size_t numRows) {
+        if (numRows <= 0x100) return StateWidth::U8;
+        if (numRows <= 0x10000) return StateWidth::U16;
+        return StateWidth::U32;
+    }
+};
+
+// 可跨输入块恢复的最长匹配扫描状态
+struct MatchCursor {
+    uint32_t state = LexerTable::kStartRow;
+    size_t lastAcceptEnd = 0;   // 最后一次到达接受状态时的结束位置
+    int lastAcceptClass = -1;   // 对应的 token 类别，-1 表示尚未接受
+};
+
+/**
+ * 从 data[pos] 起推进 cursor，直到进入死状态或到达 end
+ * 返回停下的位置；cursor.state == kDeadRow 表示匹配已终止，否则可以在更多输入到来后继续
+ */
+template <typename StateT>
+inline size_t advanceMatch(const LexerTable& table, const char* data, size_t pos, size_t end,
+                           MatchCursor& cursor) {
+    const StateT* next = table.next<StateT>();
+    const uint8_t* byteClass = table.byteClass;
+    const int32_t* accept = table.acceptClass;
+    const size_t numClasses = static_cast<size_t>(table.numClasses);
+    const SelfLoopTable* loops = table.selfLoops.get();
+
+    size_t state = cursor.state;
+    size_t run = 0;             // 连续自环的步数
+    size_t i = pos;
+    for (; i < end; ++i) {
+        size_t previous = state;
+        state = next[state * numClasses + byteClass[static_cast<unsigned char>(data[i])]];
+        if (state == LexerTable::kDeadRow) break;
+        if (state != previous) {
+            run = 0;
+        } else if (loops && ++run == SelfLoopTable::kInlineRun) {
+            // 自环已持续 kInlineRun 步：其后仍留在该状态的字节整段跳过，接受信息只需按段尾记录一次
+            i = skipSelfLoop(*loops, state, data, i + 1, end) - 1;
+        }
+        if (accept[state] >= 0) {
+            cursor.lastAcceptEnd = i + 1;
+            cursor.lastAcceptClass = accept[state];
+        }
+    }
+    cursor.state = static_cast<uint32_t>(state);
+    return i;
+}
+
+/**
+ * 从 data[pos] 开始做最长匹配
+ * 返回最后一个接受位置（无匹配时返回 pos），tokenClass 为对应的 token 类别
+ */
+template <typename StateT>
+inline size_t matchLongest(const LexerTable& table, const char* data, size_t length,
+                           size_t pos, int& tokenClass) {
+    MatchCursor cursor;
+    cursor.lastAcceptEnd = pos;
+    advanceMatch<StateT>(table, data, pos, length, cursor);
+    tokenClass = cursor.lastAcceptClass;
+    return cursor.lastAcceptEnd;
+}
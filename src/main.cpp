@@ -17,18 +17,25 @@
  *   * uses built-in token definitions (simulating the 'lang.l'-style specification).
  *   * builds and applies the corresponding lexer to user input, with the same token display
  * and DFA export capabilities as the custom mode.
+ * - Batch Lex Command ('regex_automata lex --rules FILE --input FILE...') and Compile Command
+ * ('regex_automata compile --rules FILE --output FILE') and Scanner Generator
+ * ('regex_automata gen --rules FILE --output FILE'):
+ *   * non-interactive; see batch_cli.h.
  * - Additional utilities:
  *   * Shell-safe path handling, directory creation, and file path normalization (cross-platform).
  *   * Robust error handling for regex syntax errors and system failures.
  *   * Interactive CLI with clear menus and formatted token output.
  */
 #include "lexer.h"
+#include "batch_cli.h"
 #include "regex_parser.h"
 #include "nfa.h"
 #include "dfa.h"
+#include "build_stats.h"
 #include <iostream>
 #include <fstream>
 #include <string>
+#include <string_view>
 #include <vector>
 #include <iomanip>
 #include <sys/stat.h>
@@ -52,6 +59,11 @@ std::string escapeShellArg(const std::string& arg) {
     return escaped;
 }
 
+// 交互模式在标准输出上显示构建进度（批处理子命令不安装接收器，stdout 只有结果）
+void printBuildLog(std::string_view message) {
+    std::cout << message << std::endl;
+}
+
 // 辅助函数：生成 PNG 图片
 bool generatePNG(const std::string& dotFile, const std::string& pngFile) {
     // 转义文件路径
@@ -147,6 +159,18 @@ int main(int argc, char* argv[]) {
     int choice = 0;
     std::string outputDir = ".";
 
+    // 非交互的批处理子命令
+    if (argc > 1 && std::string(argv[1]) == "lex") {
+        return runLexCommand(argc - 2, argv + 2);
+    }
+    if (argc > 1 && std::string(argv[1]) == "compile") {
+        return runCompileCommand(argc - 2, argv + 2);
+    }
+    if (argc > 1 && std::string(argv[1]) == "gen") {
+        return runGenCommand(argc - 2, argv + 2);
+    }
+    setBuildLogSink(printBuildLog);
+
     // 从命令行参数读取模式
     if (argc > 1) {
         try {
@@ -369,7 +393,9 @@ void runSingleRegexMode(const std::string& outputDir) {
         const auto& postfix = converter.getPostfix();
 
         // Step 3: 构建 NFA
-        NFAUnit nfa = regexToNFA(postfix);
+        NFAArena arena;
+        NFAFragment fragment = regexToNFA(postfix, arena);
+        NFAUnit nfa = arena.release(fragment.start, fragment.end);
         
         std::cout << "\n=== NFA ===" << std::endl;
         displayNFA(nfa);
@@ -382,7 +408,7 @@ void runSingleRegexMode(const std::string& outputDir) {
         std::vector<DFAState> dfaStates;
         std::vector<DFATransition> dfaTransitions;
         buildDFAFromNFA(nfa, dfaStates, dfaTransitions);
-        int originalNFAEndId = nfa.end->id;
+        int originalNFAEndId = nfa.end;
 
         std::cout << "\n=== Original DFA ===" << std::endl;
         displayDFA(dfaStates, dfaTransitions, originalNFAEndId);
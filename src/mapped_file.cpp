@@ -0,0 +1,84 @@
+/*
+ * mapped_file.cpp - implements MappedFile: mmap for regular files on POSIX systems, with a
+ * buffered read fallback for everything else (empty files, pipes, non-POSIX platforms).
+ */
+#include "mapped_file.h"
+#include <cerrno>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <utility>
+#if !defined(_WIN32)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define MAPPED_FILE_HAS_MMAP 1
+#endif
+
+MappedFile::MappedFile(const std::string& path) {
+#ifdef MAPPED_FILE_HAS_MMAP
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        throw std::runtime_error("Cannot open file '" + path + "': " + std::strerror(errno));
+    }
+    struct stat info;
+    if (::fstat(fd, &info) == 0 && S_ISREG(info.st_mode) && info.st_size > 0) {
+        void* addr = ::mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+        if (addr != MAP_FAILED) {
+            ::close(fd);
+            data_ = static_cast<const char*>(addr);
+            size_ = static_cast<size_t>(info.st_size);
+            mapped_ = true;
+            return;
+        }
+    }
+    ::close(fd);
+#endif
+
+    // 回退：整体读入内存
+    std::ifstream in(path, std::ios::binary);
+    if (!in) {
+        throw std::runtime_error("Cannot open file '" + path + "'");
+    }
+    std::ostringstream contents;
+    contents << in.rdbuf();
+    fallback_ = contents.str();
+    data_ = fallback_.data();
+    size_ = fallback_.size();
+}
+
+MappedFile::~MappedFile() {
+    release();
+}
+
+MappedFile::MappedFile(MappedFile&& other) noexcept {
+    *this = std::move(other);
+}
+
+MappedFile& MappedFile::operator=(MappedFile&& other) noexcept {
+    if (this != &other) {
+        release();
+        mapped_ = other.mapped_;
+        size_ = other.size_;
+        fallback_ = std::move(other.fallback_);
+        data_ = mapped_ ? other.data_ : fallback_.data();
+        other.data_ = nullptr;
+        other.size_ = 0;
+        other.mapped_ = false;
+    }
+    return *this;
+}
+
+void MappedFile::release() {
+#ifdef MAPPED_FILE_HAS_MMAP
+    if (mapped_) {
+        ::munmap(const_cast<char*>(data_), size_);
+    }
+#endif
+    data_ = nullptr;
+    size_ = 0;
+    mapped_ = false;
+    fallback_.clear();
+}
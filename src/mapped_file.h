@@ -0,0 +1,39 @@
+/*
+ * mapped_file.h - declares MappedFile, a read-only view of a whole file's contents.
+ * - On POSIX systems regular files are memory-mapped (mmap, MAP_PRIVATE), so the lexer
+ * scans the page cache directly without copying the file into a heap buffer.
+ * - Empty files, files that cannot be mapped (pipes, special files) and non-POSIX platforms
+ * fall back to reading the file into an owned buffer.
+ * - Move-only; the mapping is released when the object is destroyed.
+ */
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+class MappedFile {
+public:
+    // 打开并映射文件，失败时抛出 std::runtime_error
+    explicit MappedFile(const std::string& path);
+    ~MappedFile();
+
+    MappedFile(MappedFile&& other) noexcept;
+    MappedFile& operator=(MappedFile&& other) noexcept;
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    std::string_view data() const { return {data_, size_}; }
+    size_t size() const { return size_; }
+
+    // 是否为真正的内存映射（否则为读入的缓冲区）
+    bool isMapped() const { return mapped_; }
+
+private:
+    void release();
+
+    const char* data_ = nullptr;
+    size_t size_ = 0;
+    bool mapped_ = false;
+    std::string fallback_;   // 无法映射时的文件内容
+};
@@ -4,14 +4,18 @@
  * - CharRange & CharSet: support efficient representation of character sets
  * (including ranges like [a-z]) and epsilon transitions. `CharSet` provides
  * membership testing (`match`) and DOT-friendly string output.
- * - Node: a shared_ptr to a uniquely identified state node with optional debug name.
- * - Edge: represents a transition labeled by a `CharSet` (not a single char or string),
- * enabling compact representation of character class transitions.
- * - NFAUnit: encapsulates an NFA fragment with explicit `start` and `end` nodes
- * and a list of edges.
+ * - NFAArena: owns all NFA nodes and edges of one build. Nodes are plain integer ids handed
+ * out by the arena, edges are appended to one shared pool with per-node out-edge lists, and
+ * debug names ("q" + id) are generated lazily only for visualization.
+ * - Edge: represents a transition between two node ids labeled by a `CharSet` (not a single
+ * char or string), enabling compact representation of character class transitions.
+ * - NFAFragment: a (start, end) handle to a sub-automaton whose edges live in the arena.
+ * - NFAUnit: a finished NFA with explicit `start` and `end` nodes and the list of edges,
+ * released from the arena once construction is done.
  * - Builder functions (createBasicElement & createUnion & createConcat & createStar
  * & createQuestion & createPlus): implement Thompson's construction for regex operators,
- * including syntactic sugar (?, +).
+ * including syntactic sugar (?, +). Each call appends O(1) nodes and edges to the arena,
+ * so building an NFA is linear in the size of the regex.
  * - Utility functions: `displayNFA` prints NFA structure to console; `generateDotFile_NFA`
  * exports it to Graphviz.
  */
@@ -20,7 +24,6 @@
 #include <string>
 #include <vector>
 #include <iostream>
-#include <memory>
 #include <set>
 #include <algorithm>
 
@@ -123,38 +126,70 @@ public:
 // 基础结构定义
 // ==============================
 
-struct NodeImpl {
-    int id;
-    std::string debugName;
-    NodeImpl(int id, std::string name) : id(id), debugName(std::move(name)) {}
-};
-
-using Node = std::shared_ptr<NodeImpl>;
+// 节点的调试名称（仅在可视化时生成）
+std::string nodeDebugName(int nodeId);
 
 struct Edge {
-    Node startName; 
-    Node endName;   
+    int startId;
+    int endId;
     CharSet symbol; // 替换原来的 string tranSymbol
 };
 
 struct NFAUnit {
     std::vector<Edge> edges;
-    Node start;
-    Node end;
+    int start = -1;
+    int end = -1;
+};
+
+// 指向 arena 中一段子自动机的句柄
+struct NFAFragment {
+    int start;
+    int end;
+};
+
+/**
+ * NFA 节点与边的池：一次构建中的所有节点和边都由同一个 arena 分配，节点即整数 ID，
+ * 所有片段的边追加到同一个边池中，并按起点串成出边链表
+ */
+class NFAArena {
+public:
+    int createNode() {
+        firstOut_.push_back(-1);
+        return static_cast<int>(firstOut_.size()) - 1;
+    }
+    int nodeCount() const { return static_cast<int>(firstOut_.size()); }
+
+    void addEdge(int startId, int endId, const CharSet& symbol) {
+        edges_.push_back({startId, endId, symbol});
+        nextOut_.push_back(firstOut_[startId]);
+        firstOut_[startId] = static_cast<int>(edges_.size()) - 1;
+    }
+
+    // 把 fromId 的所有出边改为从 toId 出发，代价与 fromId 的出度成正比
+    void redirectOutEdges(int fromId, int toId);
+
+    const std::vector<Edge>& edges() const { return edges_; }
+
+    // 构建结束：把边池移交给 NFAUnit，之后 arena 不应再使用
+    NFAUnit release(int start, int end);
+
+private:
+    std::vector<Edge> edges_;
+    std::vector<int> nextOut_;   // 每条边：同一起点的下一条出边
+    std::vector<int> firstOut_;  // 每个节点：第一条出边
 };
 
 // ==============================
 // NFA 构造函数声明
 // ==============================
 
-Node createNode();
-NFAUnit createBasicElement(const CharSet& symbol);
-NFAUnit createUnion(const NFAUnit& left, const NFAUnit& right);
-NFAUnit createConcat(const NFAUnit& left, const NFAUnit& right);
-NFAUnit createStar(const NFAUnit& unit);
+NFAFragment createBasicElement(NFAArena& arena, const CharSet& symbol);
+NFAFragment createUnion(NFAArena& arena, NFAFragment left, NFAFragment right);
+NFAFragment createConcat(NFAArena& arena, NFAFragment left, NFAFragment right);
+NFAFragment createStar(NFAArena& arena, NFAFragment unit);
 // 新增语法糖支持
-NFAUnit createQuestion(const NFAUnit& unit); // ? (0 or 1)
-NFAUnit createPlus(const NFAUnit& unit);     // + (1 or more)
+NFAFragment createQuestion(NFAArena& arena, NFAFragment unit); // ? (0 or 1)
+NFAFragment createPlus(NFAArena& arena, NFAFragment unit);     // + (1 or more)
 
 void displayNFA(const NFAUnit& nfa);
 void generateDotFile_NFA(const NFAUnit& nfa, const std::string& filename = "nfa.dot");
\ No newline at end of file
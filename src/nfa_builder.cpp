@@ -12,122 +12,123 @@
  *   * createPlus for '+' (1 or more)
  * - All NFAs use epsilon transitions (represented by default-constructed `CharSet`) for
  * control flow (e.g., branching in union, looping in star).
- * - createConcat: performs node merging by redirecting edges that reference the right
- * operand's start node to the left operand's end node, avoiding unnecessary epsilon transitions.
- * - regexToNFA: uses a stack to process the postfix token stream, applying operator logic
- * and operand construction, and validates stack state for correctness.
- * - globalNodeCounter: ensures unique node IDs across the entire NFA.
+ * - Fragments are (start, end) handles; every operator appends a constant number of nodes and
+ * edges to the shared pool of the NFAArena instead of copying its operands' edge lists, so
+ * construction is linear in the size of the regex.
+ * - createConcat: performs node merging by redirecting the out-edges of the right operand's
+ * start node to the left operand's end node, avoiding unnecessary epsilon transitions.
+ * Fragment start nodes never have incoming edges, so only out-edges need to move.
+ * - regexToNFA: uses a stack of fragment handles to process the postfix token stream, applying
+ * operator logic and operand construction, and validates stack state for correctness.
+ * - NFAArena: all nodes and edges are allocated from the caller's arena, which keeps node IDs
+ * unique across every NFA of one build (e.g. all token rules of a lexer).
  */
 #include "nfa.h"
 #include "regex_parser.h"
-#include <stack>
-#include <memory>
+#include "build_stats.h"
+#include <vector>
 #include <algorithm>
 
-static int globalNodeCounter = 0;
+void NFAArena::redirectOutEdges(int fromId, int toId) {
+    int head = firstOut_[fromId];
+    if (head < 0) return;
 
-Node createNode() {
-    int id = globalNodeCounter++;
-    return std::make_shared<NodeImpl>(id, "q" + std::to_string(id));
+    int last = head;
+    for (int e = head; e >= 0; e = nextOut_[e]) {
+        edges_[e].startId = toId;
+        last = e;
+    }
+    // 把 fromId 的出边链表整体接到 toId 的链表前面
+    nextOut_[last] = firstOut_[toId];
+    firstOut_[toId] = head;
+    firstOut_[fromId] = -1;
 }
 
-NFAUnit createBasicElement(const CharSet& symbol) {
+NFAUnit NFAArena::release(int start, int end) {
     NFAUnit unit;
-    unit.start = createNode();
-    unit.end = createNode();
-    unit.edges.push_back({unit.start, unit.end, symbol});
+    unit.edges = std::move(edges_);
+    unit.start = start;
+    unit.end = end;
+    edges_.clear();
+    nextOut_.clear();
     return unit;
 }
 
-NFAUnit createUnion(const NFAUnit& left, const NFAUnit& right) {
-    NFAUnit result;
-    result.start = createNode();
-    result.end = createNode();
-    result.edges = left.edges;
-    result.edges.insert(result.edges.end(), right.edges.begin(), right.edges.end());
-    result.edges.push_back({result.start, left.start, CharSet()}); 
-    result.edges.push_back({result.start, right.start, CharSet()});
-    result.edges.push_back({left.end, result.end, CharSet()});
-    result.edges.push_back({right.end, result.end, CharSet()});
-    return result;
+NFAFragment createBasicElement(NFAArena& arena, const CharSet& symbol) {
+    NFAFragment unit{arena.createNode(), arena.createNode()};
+    arena.addEdge(unit.start, unit.end, symbol);
+    return unit;
 }
 
-NFAUnit createConcat(const NFAUnit& left, const NFAUnit& right) {
-    NFAUnit result = left; 
-    std::vector<Edge> rightEdges = right.edges;
-    for (auto& edge : rightEdges) {
-        if (edge.startName == right.start) edge.startName = left.end; 
-        if (edge.endName == right.start) edge.endName = left.end;   
-    }
-    result.edges.insert(result.edges.end(), rightEdges.begin(), rightEdges.end());
-    result.end = right.end;
+NFAFragment createUnion(NFAArena& arena, NFAFragment left, NFAFragment right) {
+    NFAFragment result{arena.createNode(), arena.createNode()};
+    arena.addEdge(result.start, left.start, CharSet());
+    arena.addEdge(result.start, right.start, CharSet());
+    arena.addEdge(left.end, result.end, CharSet());
+    arena.addEdge(right.end, result.end, CharSet());
     return result;
 }
 
-NFAUnit createStar(const NFAUnit& unit) {
-    NFAUnit result;
-    result.start = createNode();
-    result.end = createNode();
-    result.edges = unit.edges;
-    result.edges.push_back({result.start, unit.start, CharSet()});
-    result.edges.push_back({unit.end, result.end, CharSet()});
-    result.edges.push_back({unit.end, unit.start, CharSet()});
-    result.edges.push_back({result.start, result.end, CharSet()});
+NFAFragment createConcat(NFAArena& arena, NFAFragment left, NFAFragment right) {
+    arena.redirectOutEdges(right.start, left.end);
+    return {left.start, right.end};
+}
+
+NFAFragment createStar(NFAArena& arena, NFAFragment unit) {
+    NFAFragment result{arena.createNode(), arena.createNode()};
+    arena.addEdge(result.start, unit.start, CharSet());
+    arena.addEdge(unit.end, result.end, CharSet());
+    arena.addEdge(unit.end, unit.start, CharSet());
+    arena.addEdge(result.start, result.end, CharSet());
     return result;
 }
 
-NFAUnit createQuestion(const NFAUnit& unit) {
-    NFAUnit result;
-    result.start = createNode();
-    result.end = createNode();
-    result.edges = unit.edges;
-    result.edges.push_back({result.start, unit.start, CharSet()});
-    result.edges.push_back({unit.end, result.end, CharSet()});
-    result.edges.push_back({result.start, result.end, CharSet()});
+NFAFragment createQuestion(NFAArena& arena, NFAFragment unit) {
+    NFAFragment result{arena.createNode(), arena.createNode()};
+    arena.addEdge(result.start, unit.start, CharSet());
+    arena.addEdge(unit.end, result.end, CharSet());
+    arena.addEdge(result.start, result.end, CharSet());
     return result;
 }
 
-NFAUnit createPlus(const NFAUnit& unit) {
-    NFAUnit result;
-    result.start = createNode();
-    result.end = createNode();
-    result.edges = unit.edges;
-    result.edges.push_back({result.start, unit.start, CharSet()});
-    result.edges.push_back({unit.end, result.end, CharSet()});
-    result.edges.push_back({unit.end, unit.start, CharSet()});
+NFAFragment createPlus(NFAArena& arena, NFAFragment unit) {
+    NFAFragment result{arena.createNode(), arena.createNode()};
+    arena.addEdge(result.start, unit.start, CharSet());
+    arena.addEdge(unit.end, result.end, CharSet());
+    arena.addEdge(unit.end, unit.start, CharSet());
     return result;
 }
 
-NFAUnit regexToNFA(const std::vector<Token>& postfix) {
-    std::stack<NFAUnit> stk;
+NFAFragment regexToNFA(const std::vector<Token>& postfix, NFAArena& arena) {
+    std::vector<NFAFragment> stk;
 
     for (const Token& token : postfix) {
         if (token.isOperator()) {
             // 双目操作符
             if (token.opVal == '|' || token.opVal == EXPLICIT_CONCAT_OP) {
                 if (stk.size() < 2) throw RegexSyntaxError("Missing operands for operator '" + std::string(1, token.opVal) + "'.");
-                auto right = stk.top(); stk.pop();
-                auto left = stk.top(); stk.pop();
-                
-                if (token.opVal == '|') stk.push(createUnion(left, right));
-                else stk.push(createConcat(left, right));
-            } 
+                NFAFragment right = stk.back(); stk.pop_back();
+                NFAFragment left = stk.back(); stk.pop_back();
+
+                if (token.opVal == '|') stk.push_back(createUnion(arena, left, right));
+                else stk.push_back(createConcat(arena, left, right));
+            }
             // 单目操作符
             else if (token.opVal == '*' || token.opVal == '?' || token.opVal == '+') {
                 if (stk.empty()) throw RegexSyntaxError("Missing operand for operator '" + std::string(1, token.opVal) + "'.");
-                auto top = stk.top(); stk.pop();
-                
-                if (token.opVal == '*') stk.push(createStar(top));
-                else if (token.opVal == '?') stk.push(createQuestion(top));
-                else stk.push(createPlus(top));
+                NFAFragment top = stk.back(); stk.pop_back();
+
+                if (token.opVal == '*') stk.push_back(createStar(arena, top));
+                else if (token.opVal == '?') stk.push_back(createQuestion(arena, top));
+                else stk.push_back(createPlus(arena, top));
             }
         } else {
-            stk.push(createBasicElement(token.operandVal));
+            stk.push_back(createBasicElement(arena, token.operandVal));
         }
     }
 
     if (stk.size() != 1) throw RegexSyntaxError("Invalid regex: Resulting NFA stack has " + std::to_string(stk.size()) + " elements (should be 1). Check for unbalanced operators.");
-    
-    std::cout << "Regex converted to NFA successfully!" << std::endl;
-    return stk.top();
-}
\ No newline at end of file
+
+    BUILD_LOG("Regex converted to NFA successfully!");
+    return stk.back();
+}
@@ -0,0 +1,128 @@
+/*
+ * parallel_lexer.cpp - implements Lexer::tokenizeSpansParallel, speculative parallel lexing of
+ * one large input that reproduces the sequential longest-match result exactly. It features:
+ * - Chunking: the input is cut into roughly equal chunks; each chunk after the first starts at
+ * the first token-start byte (a byte only the start state can consume, e.g. a blank in lang.l)
+ * found after its nominal boundary, so its speculative start is normally a true token start.
+ * - Speculative lexing: chunks are lexed concurrently from the start state on the shared
+ * read-only table. A chunk keeps every token that begins before the next chunk's start
+ * (every action included, because all tokens take part in synchronisation) and records the
+ * position where it could not match, if any.
+ * - Stitching: a sequential pass walks the chunks in order with the true position of the next
+ * token. When that position is one of the chunk's token starts, the rest of the chunk is
+ * adopted as is (lexing from a given position is deterministic); otherwise tokens are
+ * re-lexed one by one until they meet a chunk token start or leave the chunk. Grammars without
+ * token-start bytes therefore still give correct results, only with more repair work.
+ * - Errors: an unmatched position is reported only when the stitched stream actually reaches
+ * it, through the same 'throwLexicalError' as the sequential path, so messages are identical.
+ */
+#include "lexer.h"
+#include "work_stealing.h"
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+
+namespace {
+
+struct ChunkResult {
+    size_t begin = 0;                     // 推测的起点
+    size_t limit = 0;                     // 下一块的起点：只保留起点在 [begin, limit) 内的 token
+    std::vector<TokenSpan> tokens;        // 含被跳过类别的 token
+    size_t errorPos = std::string::npos;  // 无法匹配的位置
+};
+
+template <typename StateT>
+void lexChunk(const LexerTable& table, std::string_view input, ChunkResult& chunk) {
+    size_t pos = chunk.begin;
+    while (pos < chunk.limit) {
+        int tokenClass = -1;
+        size_t end = matchLongest<StateT>(table, input.data(), input.length(), pos, tokenClass);
+        if (end == pos) {
+            chunk.errorPos = pos;
+            return;
+        }
+        chunk.tokens.push_back(makeTokenSpan(pos, end - pos, tokenClass));
+        pos = end;
+    }
+}
+
+} // namespace
+
+void Lexer::tokenizeSpansParallel(std::string_view input, std::vector<TokenSpan>& out,
+                                  unsigned numThreads, size_t minChunkSize) const {
+    if (!isBuilt_) {
+        throw std::runtime_error("Lexer not built. Call build() first.");
+    }
+
+    unsigned threads = numThreads > 0 ? numThreads : defaultWorkerCount();
+    size_t numChunks = std::min<size_t>(threads, input.length() / std::max<size_t>(minChunkSize, 1));
+    if (numChunks <= 1) {
+        tokenizeSpans(input, out);
+        return;
+    }
+
+    switch (table_.width) {
+        case StateWidth::U8:  tokenizeSpansParallelWithTable<uint8_t>(input, out, numChunks); break;
+        case StateWidth::U16: tokenizeSpansParallelWithTable<uint16_t>(input, out, numChunks); break;
+        case StateWidth::U32: tokenizeSpansParallelWithTable<uint32_t>(input, out, numChunks); break;
+    }
+}
+
+template <typename StateT>
+void Lexer::tokenizeSpansParallelWithTable(std::string_view input, std::vector<TokenSpan>& out,
+                                           size_t numChunks) const {
+    // 1. 划分：块 k 的名义边界之后第一个同步字节处开始（找不到时就从边界开始推测）
+    std::vector<ChunkResult> chunks(numChunks);
+    const size_t length = input.length();
+    for (size_t k = 1; k < numChunks; ++k) {
+        size_t begin = length / numChunks * k;
+        size_t limit = std::min(length, begin + length / numChunks);
+        size_t sync = begin;
+        while (sync < limit && !table_.tokenStartByte[static_cast<unsigned char>(input[sync])]) {
+            ++sync;
+        }
+        chunks[k].begin = sync < limit ? sync : begin;
+    }
+    for (size_t k = 1; k < numChunks; ++k) {
+        chunks[k].begin = std::max(chunks[k].begin, chunks[k - 1].begin);
+        chunks[k - 1].limit = chunks[k].begin;
+    }
+    chunks.back().limit = length;
+
+    // 2. 各块并行推测分析
+    runWorkStealing(numChunks, static_cast<unsigned>(numChunks), [&](size_t k, unsigned) {
+        lexChunk<StateT>(table_, input, chunks[k]);
+    });
+
+    // 3. 顺序拼接：pos 是真实 token 流中下一个 token 的起点
+    // 回调在这里按输入顺序调用，与顺序分析一致
+    out.clear();
+    auto emit = [&](const TokenSpan& span) {
+        if (applyTokenAction(span, lexemeOf(input, span))) out.push_back(span);
+    };
+
+    size_t pos = 0;
+    for (ChunkResult& chunk : chunks) {
+        const auto& tokens = chunk.tokens;
+        auto it = std::lower_bound(tokens.begin(), tokens.end(), pos,
+                                   [](const TokenSpan& span, size_t p) { return span.offset < p; });
+        for (;;) {
+            if (it != tokens.end() && it->offset == pos) {
+                // 与推测结果同步：其余 token 直接采用
+                for (; it != tokens.end(); ++it) emit(*it);
+                pos = tokens.back().offset + tokens.back().length;
+                if (chunk.errorPos != std::string::npos) throwLexicalError(input, chunk.errorPos);
+                break;
+            }
+            if (pos >= chunk.limit) break;
+
+            // 未同步：从真实位置重新分析一个 token
+            int tokenClass = -1;
+            size_t end = matchLongest<StateT>(table_, input.data(), length, pos, tokenClass);
+            if (end == pos) throwLexicalError(input, pos);
+            emit(makeTokenSpan(pos, end - pos, tokenClass));
+            pos = end;
+            while (it != tokens.end() && it->offset < pos) ++it;
+        }
+    }
+}
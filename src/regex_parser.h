@@ -7,7 +7,8 @@
  * operators (denoted by `EXPLICIT_CONCAT_OP`) where needed.
  * - InfixToPostfix: converts a tokenized infix regex into postfix notation using
  * the Shunting-yard algorithm with custom ISP/ICP precedence rules.
- * - regexToNFA: constructs an NFA from a postfix token sequence using Thompson’s construction.
+ * - regexToNFA: constructs an NFA from a postfix token sequence using Thompson’s construction,
+ * appending nodes and edges to a caller-owned NFAArena and returning a fragment handle.
  * - Supporting declarations: a global `EXPLICIT_CONCAT_OP` constant, a `RegexSyntaxError`
  * exception type for parse-time errors, and `CharSet` from `nfa.h` for symbol representation.
  */
@@ -78,4 +79,4 @@ private:
     int getICP(char op);
 };
 
-NFAUnit regexToNFA(const std::vector<Token>& postfix);
\ No newline at end of file
+NFAFragment regexToNFA(const std::vector<Token>& postfix, NFAArena& arena);
\ No newline at end of file
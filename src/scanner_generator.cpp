@@ -0,0 +1,315 @@
+/*
+ * scanner_generator.cpp - implements generateScanner: it reads the runtime table of a built
+ * Lexer (so a lexer loaded from a compiled image works too) and prints the generated header.
+ * The fixed parts (Token, Scanner) are emitted verbatim; the DFA is emitted either as static
+ * arrays or as one goto-linked block per state.
+ */
+#include "scanner_generator.h"
+#include "lexer_image.h"
+#include <cctype>
+#include <cstdio>
+#include <map>
+#include <set>
+#include <stdexcept>
+#include <vector>
+
+namespace {
+
+bool isCppKeyword(const std::string& word) {
+    static const std::set<std::string> keywords = {
+        "alignas", "alignof", "and", "and_eq", "asm", "auto", "bitand", "bitor", "bool", "break",
+        "case", "catch", "char", "char16_t", "char32_t", "class", "compl", "const", "constexpr",
+        "const_cast", "continue", "decltype", "default", "delete", "do", "double", "dynamic_cast",
+        "else", "enum", "explicit", "export", "extern", "false", "float", "for", "friend", "goto",
+        "if", "inline", "int", "long", "mutable", "namespace", "new", "noexcept", "not", "not_eq",
+        "nullptr", "operator", "or", "or_eq", "private", "protected", "public", "register",
+        "reinterpret_cast", "return", "short", "signed", "sizeof", "static", "static_assert",
+        "static_cast", "struct", "switch", "template", "this", "thread_local", "throw", "true",
+        "try", "typedef", "typeid", "typename", "union", "unsigned", "using", "virtual", "void",
+        "volatile", "wchar_t", "while", "xor", "xor_eq"};
+    return keywords.count(word) > 0;
+}
+
+bool isIdentifier(const std::string& word) {
+    if (word.empty() || std::isdigit(static_cast<unsigned char>(word[0]))) return false;
+    for (char c : word) {
+        if (c != '_' && !std::isalnum(static_cast<unsigned char>(c))) return false;
+    }
+    return !isCppKeyword(word);
+}
+
+bool isNamespaceName(const std::string& name) {
+    size_t begin = 0;
+    while (true) {
+        size_t end = name.find("::", begin);
+        if (!isIdentifier(name.substr(begin, end - begin))) return false;
+        if (end == std::string::npos) return true;
+        begin = end + 2;
+    }
+}
+
+std::string cppStringLiteral(const std::string& text) {
+    std::string literal = "\"";
+    for (unsigned char c : text) {
+        if (c == '"' || c == '\\') {
+            literal += '\\';
+            literal += static_cast<char>(c);
+        } else if (c < 0x20 || c >= 0x7f) {
+            // 八进制转义总是三位，不会与后面的数字字符连在一起
+            char buffer[8];
+            std::snprintf(buffer, sizeof(buffer), "\\%03o", c);
+            literal += buffer;
+        } else {
+            literal += static_cast<char>(c);
+        }
+    }
+    return literal + "\"";
+}
+
+const char* actionName(TokenAction action) {
+    switch (action) {
+        case TokenAction::Emit:      return "TokenAction::Emit";
+        case TokenAction::Skip:      return "TokenAction::Skip";
+        case TokenAction::Callback:  return "TokenAction::Callback";
+        case TokenAction::CountOnly: return "TokenAction::CountOnly";
+    }
+    return "TokenAction::Emit";
+}
+
+template <typename Value>
+void writeArray(std::ostream& out, const std::string& declaration, const std::vector<Value>& values) {
+    out << declaration << " = {";
+    for (size_t i = 0; i < values.size(); ++i) {
+        out << (i % 16 == 0 ? "\n    " : " ") << values[i] << (i + 1 < values.size() ? "," : "");
+    }
+    out << "\n};\n";
+}
+
+void writeTableMatcher(std::ostream& out, const LexerTable& table, const std::vector<uint32_t>& rows) {
+    const char* stateType = table.width == StateWidth::U8 ? "uint8_t"
+                          : table.width == StateWidth::U16 ? "uint16_t" : "uint32_t";
+    writeArray(out, std::string("inline constexpr ") + stateType + " kNext[" +
+               std::to_string(rows.size()) + "]", rows);
+    writeArray(out, "inline constexpr int32_t kAccept[" + std::to_string(table.numRows) + "]",
+               std::vector<int32_t>(table.acceptClass, table.acceptClass + table.numRows));
+    out << R"(
+// Longest match from data[pos]: returns the end of the last accepted prefix (pos if none).
+inline size_t matchLongest(const char* data, size_t length, size_t pos, int& tokenClass) {
+    size_t lastEnd = pos;
+    int lastClass = -1;
+    size_t state = 1;
+    for (size_t i = pos; i < length; ++i) {
+        state = kNext[state * )" << table.numClasses << R"( + kByteClass[static_cast<unsigned char>(data[i])]];
+        if (state == 0) break;
+        if (kAccept[state] >= 0) {
+            lastEnd = i + 1;
+            lastClass = kAccept[state];
+        }
+    }
+    tokenClass = lastClass;
+    return lastEnd;
+}
+)";
+}
+
+void writeDirectCodedMatcher(std::ostream& out, const LexerTable& table, const std::vector<uint32_t>& rows) {
+    const size_t numClasses = static_cast<size_t>(table.numClasses);
+    std::vector<bool> targeted(table.numRows, false);
+    for (uint32_t target : rows) targeted[target] = true;
+
+    out << R"(
+// Longest match from data[pos]: returns the end of the last accepted prefix (pos if none).
+// One block per DFA state; the current state is the position in the code.
+inline size_t matchLongest(const char* data, size_t length, size_t pos, int& tokenClass) {
+    size_t lastEnd = pos;
+    int lastClass = -1;
+    size_t i = pos;
+)";
+    for (int row = LexerTable::kStartRow; row < table.numRows; ++row) {
+        const int32_t accept = table.acceptClass[row];
+        // 从函数开头进入初始状态时还没有读入字节，不能记录接受；只有经转移再次进入时才记录
+        const bool skipAccept = row == static_cast<int>(LexerTable::kStartRow) && accept >= 0;
+        out << "\n";
+        if (skipAccept && targeted[row]) out << "    goto scan" << row << ";\n";
+        if (targeted[row]) out << "state" << row << ":\n";
+        if (accept >= 0 && targeted[row]) {
+            out << "    lastEnd = i;\n"
+                << "    lastClass = " << accept << ";\n";
+        }
+        if (skipAccept && targeted[row]) out << "scan" << row << ":\n";
+
+        // 按目标状态合并等价类
+        std::map<uint32_t, std::vector<size_t>> byTarget;
+        for (size_t c = 0; c < numClasses; ++c) {
+            uint32_t target = rows[row * numClasses + c];
+            if (target != LexerTable::kDeadRow) byTarget[target].push_back(c);
+        }
+        if (byTarget.empty()) {
+            out << "    goto done;\n";
+            continue;
+        }
+        out << "    if (i == length) goto done;\n"
+            << "    switch (kByteClass[static_cast<unsigned char>(data[i++])]) {\n";
+        for (const auto& [target, classes] : byTarget) {
+            out << "        ";
+            for (size_t c : classes) out << "case " << c << ": ";
+            out << "goto state" << target << ";\n";
+        }
+        out << "        default: goto done;\n"
+            << "    }\n";
+    }
+    out << R"(
+done:
+    tokenClass = lastClass;
+    return lastEnd;
+}
+)";
+}
+
+} // namespace
+
+void generateScanner(const Lexer& lexer, const ScannerOptions& options, std::ostream& out) {
+    if (!lexer.isBuilt()) {
+        throw std::runtime_error("Lexer not built. Call build() first.");
+    }
+    if (!isNamespaceName(options.namespaceName)) {
+        throw std::runtime_error("Invalid namespace name '" + options.namespaceName + "'");
+    }
+
+    const LexerTable& table = lexer.getTable();
+    const std::vector<TokenClass>& tokenClasses = lexer.getTokenClasses();
+    const std::vector<uint32_t> rows = imageContentsOf(table).rows;   // 按 uint32 读出，与表宽度无关
+    const bool directCoded = options.style == ScannerStyle::DirectCoded;
+
+    char hash[32];
+    std::snprintf(hash, sizeof(hash), "0x%016llx", static_cast<unsigned long long>(table.ruleHash));
+    out << "/*\n"
+        << " * Generated by 'regex_automata gen' (" << (directCoded ? "direct-coded" : "table-driven")
+        << " scanner). Do not edit.\n"
+        << " * Rule set hash " << hash << ": " << tokenClasses.size() << " token classes, "
+        << table.numRows - 1 << " DFA states, " << table.numClasses << " byte classes.\n"
+        << " * Self-contained: depends only on the C++17 standard library.\n"
+        << " */\n";
+    out << R"(#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+
+namespace )" << options.namespaceName << " {\n\n";
+
+    // 1. 类别：名称为合法标识符的类别同时给出枚举值
+    out << "constexpr int kNumTokenClasses = " << tokenClasses.size() << ";\n\n";
+    out << "enum TokenClass : int {\n";
+    std::set<std::string> enumerated;
+    for (const auto& tc : tokenClasses) {
+        if (isIdentifier(tc.name) && enumerated.insert(tc.name).second) {
+            out << "    " << tc.name << " = " << tc.id << ",\n";
+        }
+    }
+    out << "};\n\n";
+    out << "inline constexpr const char* kTokenClassNames[kNumTokenClasses] = {\n";
+    for (const auto& tc : tokenClasses) {
+        out << "    " << cppStringLiteral(tc.name) << ",\n";
+    }
+    out << "};\n\n";
+    out << "enum class TokenAction : uint8_t { Emit, Skip, Callback, CountOnly };\n\n";
+    out << "inline constexpr TokenAction kTokenActions[kNumTokenClasses] = {\n";
+    for (const auto& tc : tokenClasses) {
+        out << "    " << actionName(table.classAction[tc.id]) << ",\n";
+    }
+    out << "};\n\n";
+
+    out << R"(struct Token {
+    std::string_view lexeme;    // view into the scanned input
+    size_t offset;
+    int tokenClass;
+    int line;                   // 1-based
+    int column;                 // 1-based, counted in bytes
+};
+
+namespace detail {
+
+)";
+
+    // 2. DFA
+    writeArray(out, "inline constexpr uint8_t kByteClass[256]",
+               std::vector<int>(table.byteClass, table.byteClass + 256));
+    if (directCoded) {
+        writeDirectCodedMatcher(out, table, rows);
+    } else {
+        writeTableMatcher(out, table, rows);
+    }
+
+    // 3. 扫描器
+    out << R"(
+} // namespace detail
+
+// Pulls tokens from an in-memory input. Skip tokens are dropped, Callback tokens are passed to
+// the callback (dropped when none is set), CountOnly tokens are only counted.
+class Scanner {
+public:
+    using Callback = void (*)(const Token& token, void* user);
+
+    explicit Scanner(std::string_view input, Callback callback = nullptr, void* user = nullptr)
+        : input_(input), callback_(callback), user_(user) {}
+
+    // Next emitted token; false at end of input. Throws std::runtime_error on unrecognized input.
+    bool next(Token& token) {
+        while (pos_ < input_.size()) {
+            int tokenClass = -1;
+            size_t start = pos_;
+            size_t end = detail::matchLongest(input_.data(), input_.size(), start, tokenClass);
+            if (end == start) throwLexicalError();
+
+            Token current{input_.substr(start, end - start), start, tokenClass, line_, column_};
+            for (; pos_ < end; ++pos_) {
+                if (input_[pos_] == '\n') {
+                    ++line_;
+                    column_ = 1;
+                } else {
+                    ++column_;
+                }
+            }
+            switch (kTokenActions[tokenClass]) {
+                case TokenAction::Emit:
+                    token = current;
+                    return true;
+                case TokenAction::Skip:
+                    break;
+                case TokenAction::Callback:
+                    if (callback_) callback_(current, user_);
+                    break;
+                case TokenAction::CountOnly:
+                    ++counts_[tokenClass];
+                    break;
+            }
+        }
+        return false;
+    }
+
+    // Number of CountOnly tokens of the class seen so far.
+    size_t count(int tokenClass) const { return counts_[tokenClass]; }
+
+private:
+    [[noreturn]] void throwLexicalError() const {
+        std::string_view context = input_.substr(pos_, 20);
+        throw std::runtime_error("Lexical error at line " + std::to_string(line_) +
+                                 ", column " + std::to_string(column_) +
+                                 ": unexpected character '" + std::string(1, context[0]) + "'\n" +
+                                 "Context: \"" + std::string(context) + "\"");
+    }
+
+    std::string_view input_;
+    Callback callback_;
+    void* user_;
+    size_t pos_ = 0;
+    int line_ = 1;
+    int column_ = 1;
+    size_t counts_[kNumTokenClasses] = {};
+};
+
+} // namespace )" << options.namespaceName << "\n";
+}
@@ -0,0 +1,35 @@
+/*
+ * scanner_generator.h - declares the generator that turns a built Lexer into a standalone C++
+ * scanner, in the spirit of flex for lang.l. It features:
+ * - Self-contained output: one header with the token class enum and names, the resolved token
+ * actions, the DFA and a small Scanner class; it includes only the C++17 standard library, so
+ * it can be shipped into programs that must not link the automaton builder.
+ * - Two code shapes: 'Table' bakes the byte-class map, next-state table (narrowest state id
+ * width) and accept array in as static data and runs the usual table-driven loop; 'DirectCoded'
+ * emits one labelled block per DFA state that switches on the byte class and jumps straight to
+ * the next state with goto, letting the compiler keep the state in the program counter and
+ * specialise every state.
+ * - Same results as Lexer::tokenize: longest match with rule-order priority, actions (emit, skip,
+ * callback, count-only) and the same lexical error message.
+ */
+#pragma once
+
+#include "lexer.h"
+#include <ostream>
+#include <string>
+
+enum class ScannerStyle {
+    Table,          // 静态转移表 + 查表循环
+    DirectCoded     // 每个状态一段代码，switch + goto
+};
+
+struct ScannerOptions {
+    ScannerStyle style = ScannerStyle::DirectCoded;
+    std::string namespaceName = "generated_lexer";   // 生成代码所在的命名空间
+};
+
+/**
+ * 把已构建（或 load 读入）的 lexer 生成为独立的 C++ 扫描器头文件，写入 out
+ * lexer 未构建或命名空间名不是合法标识符时抛出 std::runtime_error
+ */
+void generateScanner(const Lexer& lexer, const ScannerOptions& options, std::ostream& out);
@@ -0,0 +1,173 @@
+/*
+ * self_loop.cpp - builds the self-loop table of a LexerTable and implements the SSE2 / AVX2
+ * skip kernels. A byte is in range r when (byte - low) <= span as unsigned bytes, which SSE2
+ * expresses as min_epu8(x, span) == x; the first byte outside every range is found through the
+ * movemask of the combined test. Runs shorter than one vector are finished byte by byte.
+ */
+#include "self_loop.h"
+#include "lexer_table.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define SELF_LOOP_HAS_SSE2
+#include <emmintrin.h>
+#endif
+#if defined(SELF_LOOP_HAS_SSE2) && (defined(__GNUC__) || defined(__clang__))
+#define SELF_LOOP_HAS_AVX2
+#define SELF_LOOP_AVX2_TARGET __attribute__((target("avx2")))
+#include <immintrin.h>
+#elif defined(SELF_LOOP_HAS_SSE2) && defined(__AVX2__)
+#define SELF_LOOP_HAS_AVX2
+#define SELF_LOOP_AVX2_TARGET
+#include <immintrin.h>
+#endif
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+namespace {
+
+bool inLoop(const SelfLoopTable::Loop& loop, unsigned char byte) {
+    for (int r = 0; r < loop.numRanges; ++r) {
+        if (static_cast<uint8_t>(byte - loop.low[r]) <= loop.span[r]) return true;
+    }
+    return false;
+}
+
+size_t skipScalar(const SelfLoopTable::Loop& loop, const char* data, size_t pos, size_t end) {
+    while (pos < end && inLoop(loop, static_cast<unsigned char>(data[pos]))) ++pos;
+    return pos;
+}
+
+[[maybe_unused]] unsigned lowestBit(uint32_t mask) {
+#if defined(_MSC_VER) && !defined(__clang__)
+    unsigned long index;
+    _BitScanForward(&index, mask);
+    return static_cast<unsigned>(index);
+#else
+    return static_cast<unsigned>(__builtin_ctz(mask));
+#endif
+}
+
+#ifdef SELF_LOOP_HAS_SSE2
+size_t skipSSE2(const SelfLoopTable::Loop& loop, const char* data, size_t pos, size_t end) {
+    __m128i low[SelfLoopTable::kMaxRanges], span[SelfLoopTable::kMaxRanges];
+    for (int r = 0; r < loop.numRanges; ++r) {
+        low[r] = _mm_set1_epi8(static_cast<char>(loop.low[r]));
+        span[r] = _mm_set1_epi8(static_cast<char>(loop.span[r]));
+    }
+    while (end - pos >= 16) {
+        __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + pos));
+        __m128i hit = _mm_setzero_si128();
+        for (int r = 0; r < loop.numRanges; ++r) {
+            __m128i offset = _mm_sub_epi8(bytes, low[r]);
+            hit = _mm_or_si128(hit, _mm_cmpeq_epi8(_mm_min_epu8(offset, span[r]), offset));
+        }
+        uint32_t miss = ~static_cast<uint32_t>(_mm_movemask_epi8(hit)) & 0xFFFFu;
+        if (miss != 0) return pos + lowestBit(miss);
+        pos += 16;
+    }
+    return skipScalar(loop, data, pos, end);
+}
+#endif
+
+#ifdef SELF_LOOP_HAS_AVX2
+SELF_LOOP_AVX2_TARGET
+size_t skipAVX2(const SelfLoopTable::Loop& loop, const char* data, size_t pos, size_t end) {
+    __m256i low[SelfLoopTable::kMaxRanges], span[SelfLoopTable::kMaxRanges];
+    for (int r = 0; r < loop.numRanges; ++r) {
+        low[r] = _mm256_set1_epi8(static_cast<char>(loop.low[r]));
+        span[r] = _mm256_set1_epi8(static_cast<char>(loop.span[r]));
+    }
+    while (end - pos >= 32) {
+        __m256i bytes = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + pos));
+        __m256i hit = _mm256_setzero_si256();
+        for (int r = 0; r < loop.numRanges; ++r) {
+            __m256i offset = _mm256_sub_epi8(bytes, low[r]);
+            hit = _mm256_or_si256(hit, _mm256_cmpeq_epi8(_mm256_min_epu8(offset, span[r]), offset));
+        }
+        uint32_t miss = ~static_cast<uint32_t>(_mm256_movemask_epi8(hit));
+        if (miss != 0) return pos + lowestBit(miss);
+        pos += 32;
+    }
+    return skipScalar(loop, data, pos, end);
+}
+#endif
+
+template <typename StateT>
+void collectLoops(const LexerTable& table, SelfLoopTable& loops) {
+    const StateT* next = table.next<StateT>();
+    const size_t numClasses = static_cast<size_t>(table.numClasses);
+    loops.loopOf.assign(static_cast<size_t>(table.numRows), -1);
+
+    for (size_t row = LexerTable::kStartRow; row < static_cast<size_t>(table.numRows); ++row) {
+        // 自环字节按值连续的段即为区间
+        SelfLoopTable::Loop loop;
+        bool fits = true;
+        for (int b = 0; b < 256 && fits; ++b) {
+            if (next[row * numClasses + table.byteClass[b]] != row) continue;
+            int last = b;
+            while (last + 1 < 256 && next[row * numClasses + table.byteClass[last + 1]] == row) ++last;
+            if (loop.numRanges == SelfLoopTable::kMaxRanges) {
+                fits = false;
+            } else {
+                loop.low[loop.numRanges] = static_cast<uint8_t>(b);
+                loop.span[loop.numRanges] = static_cast<uint8_t>(last - b);
+                ++loop.numRanges;
+            }
+            b = last;
+        }
+        if (fits && loop.numRanges > 0) {
+            loops.loopOf[row] = static_cast<int32_t>(loops.loops.size());
+            loops.loops.push_back(loop);
+        }
+    }
+}
+
+} // namespace
+
+SimdLevel detectSimdLevel() {
+#if defined(SELF_LOOP_HAS_AVX2) && defined(__AVX2__)
+    return SimdLevel::AVX2;
+#elif defined(SELF_LOOP_HAS_AVX2)
+    return __builtin_cpu_supports("avx2") ? SimdLevel::AVX2 : SimdLevel::SSE2;
+#elif defined(SELF_LOOP_HAS_SSE2)
+    return SimdLevel::SSE2;
+#else
+    return SimdLevel::None;
+#endif
+}
+
+std::shared_ptr<const SelfLoopTable> buildSelfLoopTable(const LexerTable& table, SimdLevel level) {
+    // 不能只看编译期宏：AVX2 核心经 target 属性编入，CPU 不支持时调用会触发非法指令
+    const SimdLevel supported = detectSimdLevel();
+    if (static_cast<int>(level) > static_cast<int>(supported)) level = supported;
+
+    auto loops = std::make_shared<SelfLoopTable>();
+    switch (level) {
+        case SimdLevel::None:
+            return nullptr;
+        case SimdLevel::SSE2:
+#ifdef SELF_LOOP_HAS_SSE2
+            loops->skip = skipSSE2;
+            break;
+#else
+            return nullptr;
+#endif
+        case SimdLevel::AVX2:
+#ifdef SELF_LOOP_HAS_AVX2
+            loops->skip = skipAVX2;
+            break;
+#else
+            return nullptr;
+#endif
+    }
+    loops->level = level;
+
+    switch (table.width) {
+        case StateWidth::U8:  collectLoops<uint8_t>(table, *loops); break;
+        case StateWidth::U16: collectLoops<uint16_t>(table, *loops); break;
+        case StateWidth::U32: collectLoops<uint32_t>(table, *loops); break;
+    }
+    if (loops->loops.empty()) return nullptr;
+    return loops;
+}
@@ -0,0 +1,78 @@
+/*
+ * self_loop.h - vectorized scanning of self-looping DFA states. Most input bytes are consumed
+ * by states that stay put on a whole character class (identifier bodies, digit runs), one
+ * table step per byte. It features:
+ * - Detection: at bind time every row whose self-loop bytes form at most kMaxRanges byte
+ * ranges gets a loop entry; [_A-Za-z0-9] is four ranges, [0-9] one. Rows with wider loop sets
+ * stay on the table path.
+ * - Vector skip: once the scanner has stayed in the same state for kInlineRun table steps,
+ * 'skipSelfLoop' tests 16 (SSE2) or 32 (AVX2) bytes per step against the ranges with unsigned
+ * compares and jumps to the first byte that leaves the loop; the state and the accept data
+ * cannot change inside the run, so the longest-match result is the same as the byte-by-byte
+ * loop. Shorter runs (numbers, most lang.l identifiers) never pay for the call.
+ * - Dispatch: opt-in per table through Lexer::setSimdLevel (AVX2 through a target attribute on
+ * GCC/Clang so no extra compiler flags are needed). Tables start without a loop table, as do
+ * builds without x86 vectors and SimdLevel::None, and scan with the plain table loop: on
+ * lexer_bench the skip only pays off on the identifier corpus.
+ */
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+struct LexerTable;
+
+// 自环加速使用的指令集
+enum class SimdLevel : uint8_t {
+    None,       // 不加速，逐字节查表
+    SSE2,       // 每次 16 字节
+    AVX2        // 每次 32 字节
+};
+
+/**
+ * 各行的自环字节集合，以不超过 kMaxRanges 个字节区间表示：
+ * 字节 b 使状态留在原地 <=> 存在 r 使 (uint8_t)(b - low[r]) <= span[r]
+ */
+struct SelfLoopTable {
+    static constexpr int kMaxRanges = 4;
+    // 扫描器先按表逐字节走完这么多步自环，再调用向量扫描：短的段不值得一次调用与向量准备
+    static constexpr size_t kInlineRun = 8;
+
+    struct Loop {
+        uint8_t numRanges = 0;
+        uint8_t low[kMaxRanges] = {};
+        uint8_t span[kMaxRanges] = {};
+    };
+
+    // 返回 [pos, end) 中第一个不在自环集合内的位置（都在时返回 end）
+    using SkipFn = size_t (*)(const Loop& loop, const char* data, size_t pos, size_t end);
+
+    std::vector<int32_t> loopOf;    // 每行：loops 中的下标，-1 表示该行没有可加速的自环
+    std::vector<Loop> loops;
+    SkipFn skip = nullptr;
+    SimdLevel level = SimdLevel::None;
+};
+
+/**
+ * 当前 CPU 支持的最高加速级别
+ */
+SimdLevel detectSimdLevel();
+
+/**
+ * 为 table 建立自环表；level 高于 detectSimdLevel() 时降为该级别（与字节分类器相同），
+ * 降级后为 None 或没有可加速的状态时返回 nullptr；结果的 level 为实际使用的级别
+ */
+std::shared_ptr<const SelfLoopTable> buildSelfLoopTable(const LexerTable& table,
+                                                        SimdLevel level = detectSimdLevel());
+
+/**
+ * 扫描器刚经自环回到 state、下一个待读字节为 data[pos] 时调用：
+ * 返回第一个会离开 state 的字节位置（state 没有加速项时返回 pos）
+ */
+inline size_t skipSelfLoop(const SelfLoopTable& loops, size_t state, const char* data,
+                           size_t pos, size_t end) {
+    int32_t index = loops.loopOf[state];
+    return index < 0 ? pos : loops.skip(loops.loops[index], data, pos, end);
+}
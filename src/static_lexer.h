@@ -0,0 +1,513 @@
+/*
+ * static_lexer.h - builds a lexer for a rule list known at compile time entirely in constant
+ * evaluation (C++17 constexpr), so the transition table is a 'constexpr' object and the scanner
+ * is specialised for its exact dimensions. It features:
+ * - StaticRule: a (name, regex, action) triple; a rule list is a constexpr array of them and is
+ * the single source of truth shared with the runtime Lexer (see lang_rules.h).
+ * - Fixed-capacity pipeline: regex parsing (same syntax as regex_preprocessor.cpp: quoted strings
+ * with escapes, [...] classes with ranges, '|', '*', '+', '?', parentheses), Thompson NFA
+ * construction, byte equivalence classes by partition refinement, and subset construction over
+ * bitset state sets, all with arrays sized by template parameters instead of heap containers.
+ * Exceeding a capacity or a malformed regex stops compilation at the offending throw.
+ * - Exact-size result: the DFA is explored once to measure it and once more to fill a StaticLexer
+ * whose table sizes and state id width are template arguments, in the same layout as LexerTable
+ * (row 0 dead, start in row 1, per-row accept class, per-class action, token-start bytes).
+ * - StaticLexer::matchLongest / forEachToken: the longest-match loop with the row stride as a
+ * compile-time constant; also usable in constant expressions. 'table()' exposes the arrays as a
+ * LexerTable for Lexer::fromTable and the other runtime front-ends.
+ * The DFA is not minimized; it is only ever larger than the runtime one, never different.
+ */
+#pragma once
+
+#include "lexer_table.h"
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <string_view>
+#include <type_traits>
+
+struct StaticRule {
+    const char* name;
+    const char* regex;
+    TokenAction action;
+};
+
+namespace static_lexer_detail {
+
+// 常量求值中执行到这里即编译失败，报错位置指向本函数的调用处
+[[noreturn]] inline void fail(const char* message) {
+    throw std::logic_error(message);
+}
+
+constexpr int lowestBit(uint64_t bits) {
+    int index = 0;
+    for (int width = 32; width > 0; width /= 2) {
+        if ((bits & ((uint64_t(1) << width) - 1)) == 0) {
+            bits >>= width;
+            index += width;
+        }
+    }
+    return index;
+}
+
+struct ByteSet {
+    uint64_t bits[4] = {};
+
+    constexpr void add(unsigned char c) { bits[c >> 6] |= uint64_t(1) << (c & 63); }
+    constexpr bool contains(unsigned char c) const { return (bits[c >> 6] >> (c & 63)) & 1; }
+};
+
+template <size_t Capacity>
+struct StateSet {
+    static constexpr size_t kWords = (Capacity + 63) / 64;
+    uint64_t words[kWords] = {};
+
+    constexpr void add(int s) { words[s >> 6] |= uint64_t(1) << (s & 63); }
+    constexpr bool contains(int s) const { return (words[s >> 6] >> (s & 63)) & 1; }
+    constexpr bool operator==(const StateSet& other) const {
+        for (size_t w = 0; w < kWords; ++w) {
+            if (words[w] != other.words[w]) return false;
+        }
+        return true;
+    }
+    constexpr uint64_t hash() const {
+        uint64_t h = 1469598103934665603ull;
+        for (size_t w = 0; w < kWords; ++w) h = (h ^ words[w]) * 1099511628211ull;
+        return h;
+    }
+};
+
+// Thompson NFA：每个状态至多一条字符边和两条 epsilon 边
+template <size_t Capacity>
+struct Nfa {
+    struct State {
+        int charTarget = -1;
+        ByteSet chars;
+        int epsilon[2] = {-1, -1};
+        int acceptRule = -1;
+    };
+
+    State states[Capacity] = {};
+    int numStates = 0;
+
+    constexpr int addState() {
+        if (numStates == static_cast<int>(Capacity)) fail("static lexer: NFA state capacity exceeded");
+        return numStates++;
+    }
+    constexpr void addEpsilon(int from, int to) {
+        State& state = states[from];
+        state.epsilon[state.epsilon[0] < 0 ? 0 : 1] = to;
+    }
+};
+
+struct Fragment {
+    int start = -1;
+    int end = -1;       // 没有出边的终态
+};
+
+constexpr unsigned char escapedChar(char c) {
+    switch (c) {
+        case 'n': return '\n';
+        case 't': return '\t';
+        case 'r': return '\r';
+        case '0': return '\0';
+        default: return static_cast<unsigned char>(c);
+    }
+}
+
+// 递归下降解析正则，直接按 Thompson 构造生成 NFA 片段
+template <size_t Capacity>
+class RegexCompiler {
+public:
+    constexpr RegexCompiler(Nfa<Capacity>& nfa, const char* regex) : nfa_(nfa), regex_(regex) {}
+
+    constexpr Fragment compile() {
+        Fragment fragment = parseAlternation();
+        if (peek() != '\0') fail("static lexer: unbalanced ')' in regex");
+        return fragment;
+    }
+
+private:
+    constexpr char peek() const { return regex_[pos_]; }
+
+    constexpr Fragment parseAlternation() {
+        Fragment result = parseConcatenation();
+        while (peek() == '|') {
+            ++pos_;
+            Fragment right = parseConcatenation();
+            int start = nfa_.addState();
+            int end = nfa_.addState();
+            nfa_.addEpsilon(start, result.start);
+            nfa_.addEpsilon(start, right.start);
+            nfa_.addEpsilon(result.end, end);
+            nfa_.addEpsilon(right.end, end);
+            result = {start, end};
+        }
+        return result;
+    }
+
+    constexpr Fragment parseConcatenation() {
+        Fragment result;
+        while (peek() != '\0' && peek() != '|' && peek() != ')') {
+            Fragment atom;
+            if (peek() == '"') {
+                // 字符串中的每个字符都是独立的操作数，后缀运算符只作用于最后一个字符
+                ++pos_;
+                bool hasChar = false;
+                while (peek() != '"') {
+                    if (peek() == '\0') fail("static lexer: unterminated string literal in regex");
+                    unsigned char c = static_cast<unsigned char>(regex_[pos_++]);
+                    if (c == '\\') {
+                        if (peek() == '\0') fail("static lexer: unterminated escape sequence in regex");
+                        c = escapedChar(regex_[pos_++]);
+                    }
+                    if (hasChar) result = concatenate(result, atom);
+                    atom = literal(singleByte(c));
+                    hasChar = true;
+                }
+                ++pos_;
+                if (!hasChar) continue;
+            } else {
+                atom = parseAtom();
+            }
+            result = concatenate(result, parsePostfix(atom));
+        }
+        if (result.start < 0) fail("static lexer: empty regex or alternative");
+        return result;
+    }
+
+    constexpr Fragment parsePostfix(Fragment atom) {
+        while (peek() == '*' || peek() == '+' || peek() == '?') {
+            char op = regex_[pos_++];
+            int end = nfa_.addState();
+            if (op == '+') {
+                nfa_.addEpsilon(atom.end, atom.start);
+                nfa_.addEpsilon(atom.end, end);
+                atom = {atom.start, end};
+            } else {
+                int start = nfa_.addState();
+                nfa_.addEpsilon(start, atom.start);
+                nfa_.addEpsilon(start, end);
+                if (op == '*') nfa_.addEpsilon(atom.end, atom.start);
+                nfa_.addEpsilon(atom.end, end);
+                atom = {start, end};
+            }
+        }
+        return atom;
+    }
+
+    constexpr Fragment parseAtom() {
+        char c = regex_[pos_++];
+        if (c == '(') {
+            Fragment inner = parseAlternation();
+            if (peek() != ')') fail("static lexer: unmatched '(' in regex");
+            ++pos_;
+            return inner;
+        }
+        if (c == '[') {
+            // 与 parseCharSet 相同：内容直到第一个 ']'，"x-y" 为区间，其余为单个字符
+            size_t begin = pos_;
+            while (peek() != ']') {
+                if (peek() == '\0') fail("static lexer: unmatched '[' in regex");
+                ++pos_;
+            }
+            size_t end = pos_++;
+            ByteSet chars;
+            for (size_t k = begin; k < end; ++k) {
+                if (k + 2 < end && regex_[k + 1] == '-') {
+                    if (regex_[k] > regex_[k + 2]) fail("static lexer: invalid range in character class");
+                    for (int b = static_cast<unsigned char>(regex_[k]); b <= static_cast<unsigned char>(regex_[k + 2]); ++b) {
+                        chars.add(static_cast<unsigned char>(b));
+                    }
+                    k += 2;
+                } else {
+                    chars.add(static_cast<unsigned char>(regex_[k]));
+                }
+            }
+            return literal(chars);
+        }
+        if (c == '*' || c == '+' || c == '?' || c == '|' || c == ')') {
+            fail("static lexer: operator without operand in regex");
+        }
+        return literal(singleByte(static_cast<unsigned char>(c)));
+    }
+
+    static constexpr ByteSet singleByte(unsigned char c) {
+        ByteSet chars;
+        chars.add(c);
+        return chars;
+    }
+
+    constexpr Fragment literal(const ByteSet& chars) {
+        int start = nfa_.addState();
+        int end = nfa_.addState();
+        nfa_.states[start].charTarget = end;
+        nfa_.states[start].chars = chars;
+        return {start, end};
+    }
+
+    constexpr Fragment concatenate(Fragment left, Fragment right) {
+        if (left.start < 0) return right;
+        nfa_.addEpsilon(left.end, right.start);
+        return {left.start, right.end};
+    }
+
+    Nfa<Capacity>& nfa_;
+    const char* regex_;
+    size_t pos_ = 0;
+};
+
+// 规则表 -> NFA -> 字节等价类 -> 子集构造
+template <size_t MaxNfaStates, size_t MaxDfaStates>
+class SubsetBuilder {
+public:
+    using Set = StateSet<MaxNfaStates>;
+
+    template <size_t NumRules>
+    constexpr explicit SubsetBuilder(const StaticRule (&rules)[NumRules]) {
+        // 1. 每条规则一个片段，终态记录规则序号（序号小者优先）；初始状态经一串分叉状态连到各片段
+        int previousSplit = -1;
+        for (size_t r = 0; r < NumRules; ++r) {
+            Fragment fragment = RegexCompiler<MaxNfaStates>(nfa_, rules[r].regex).compile();
+            nfa_.states[fragment.end].acceptRule = static_cast<int>(r);
+            int split = nfa_.addState();
+            nfa_.addEpsilon(split, fragment.start);
+            if (previousSplit < 0) {
+                start_ = split;
+            } else {
+                nfa_.addEpsilon(previousSplit, split);
+            }
+            previousSplit = split;
+        }
+
+        // 2. 字节等价类：按每条字符边的字符集依次细分
+        numClasses_ = 1;
+        for (int s = 0; s < nfa_.numStates; ++s) {
+            if (nfa_.states[s].charTarget < 0) continue;
+            int remap[2][256] = {};
+            int count = 0;
+            for (int b = 0; b < 256; ++b) {
+                int& target = remap[nfa_.states[s].chars.contains(static_cast<unsigned char>(b))][byteClass_[b]];
+                if (target == 0) target = ++count;
+                byteClass_[b] = static_cast<uint8_t>(target - 1);
+            }
+            numClasses_ = count;
+        }
+        for (int b = 255; b >= 0; --b) representative_[byteClass_[b]] = static_cast<unsigned char>(b);
+
+        // 3. 初始 DFA 状态；其余状态在 explore 中按编号顺序发现
+        Set initial;
+        initial.add(start_);
+        closure(initial);
+        findOrAdd(initial);
+    }
+
+    /**
+     * 依次计算每个 DFA 状态在每个等价类上的转移，onTransition(state, class, target) 中
+     * target 为 -1 表示死状态；状态按发现顺序编号，多次调用结果相同
+     */
+    template <typename OnTransition>
+    constexpr void explore(OnTransition&& onTransition) {
+        for (int d = 0; d < numDfaStates_; ++d) {
+            for (int c = 0; c < numClasses_; ++c) {
+                onTransition(d, c, step(d, c));
+            }
+        }
+    }
+
+    constexpr int numDfaStates() const { return numDfaStates_; }
+    constexpr int numClasses() const { return numClasses_; }
+    constexpr uint8_t byteClass(int b) const { return byteClass_[b]; }
+
+    // DFA 状态接受的优先规则，-1 表示不接受
+    constexpr int acceptRule(int d) const {
+        int best = -1;
+        for (int s = 0; s < nfa_.numStates; ++s) {
+            int rule = nfa_.states[s].acceptRule;
+            if (rule >= 0 && dfaSets_[d].contains(s) && (best < 0 || rule < best)) best = rule;
+        }
+        return best;
+    }
+
+private:
+    constexpr void closure(Set& set) const {
+        int stack[MaxNfaStates] = {};
+        int top = 0;
+        for (int s = 0; s < nfa_.numStates; ++s) {
+            if (set.contains(s)) stack[top++] = s;
+        }
+        while (top > 0) {
+            const auto& state = nfa_.states[stack[--top]];
+            for (int target : state.epsilon) {
+                if (target >= 0 && !set.contains(target)) {
+                    set.add(target);
+                    stack[top++] = target;
+                }
+            }
+        }
+    }
+
+    constexpr int findOrAdd(const Set& set) {
+        uint64_t hash = set.hash();
+        for (int d = 0; d < numDfaStates_; ++d) {
+            if (hashes_[d] == hash && dfaSets_[d] == set) return d;
+        }
+        if (numDfaStates_ == static_cast<int>(MaxDfaStates)) fail("static lexer: DFA state capacity exceeded");
+        dfaSets_[numDfaStates_] = set;
+        hashes_[numDfaStates_] = hash;
+        return numDfaStates_++;
+    }
+
+    constexpr int step(int d, int c) {
+        const unsigned char byte = representative_[c];
+        Set moved;
+        bool any = false;
+        for (size_t w = 0; w < Set::kWords; ++w) {
+            for (uint64_t bits = dfaSets_[d].words[w]; bits != 0; bits &= bits - 1) {
+                const auto& state = nfa_.states[w * 64 + lowestBit(bits)];
+                if (state.charTarget >= 0 && state.chars.contains(byte)) {
+                    moved.add(state.charTarget);
+                    any = true;
+                }
+            }
+        }
+        if (!any) return -1;
+        closure(moved);
+        return findOrAdd(moved);
+    }
+
+    Nfa<MaxNfaStates> nfa_;
+    int start_ = -1;
+    uint8_t byteClass_[256] = {};
+    unsigned char representative_[256] = {};
+    int numClasses_ = 0;
+    Set dfaSets_[MaxDfaStates] = {};
+    uint64_t hashes_[MaxDfaStates] = {};
+    int numDfaStates_ = 0;
+};
+
+struct Shape {
+    int numRows;
+    int numClasses;
+};
+
+template <size_t MaxNfaStates, size_t MaxDfaStates, size_t NumRules>
+constexpr Shape measure(const StaticRule (&rules)[NumRules]) {
+    SubsetBuilder<MaxNfaStates, MaxDfaStates> builder(rules);
+    builder.explore([](int, int, int) {});
+    return {builder.numDfaStates() + 1, builder.numClasses()};
+}
+
+template <int NumRows>
+using StateFor = std::conditional_t<(NumRows <= 0x100), uint8_t,
+                 std::conditional_t<(NumRows <= 0x10000), uint16_t, uint32_t>>;
+
+} // namespace static_lexer_detail
+
+/**
+ * 编译期构建的 lexer：各数组与 LexerTable 同布局，维度均为编译期常量
+ */
+template <int NumRows, int NumClasses, int NumTokenClasses>
+struct StaticLexer {
+    using State = static_lexer_detail::StateFor<NumRows>;
+    static constexpr int kNumRows = NumRows;
+    static constexpr int kNumClasses = NumClasses;
+    static constexpr int kNumTokenClasses = NumTokenClasses;
+
+    uint8_t byteClass[256] = {};
+    uint8_t tokenStartByte[256] = {};
+    State next[NumRows * NumClasses] = {};
+    int32_t acceptClass[NumRows] = {};
+    TokenAction actions[NumTokenClasses] = {};
+
+    /**
+     * 从 data[pos] 开始做最长匹配，返回最后一个接受位置（无匹配时返回 pos）
+     */
+    constexpr size_t matchLongest(const char* data, size_t length, size_t pos, int& tokenClass) const {
+        size_t lastEnd = pos;
+        int lastClass = -1;
+        size_t state = LexerTable::kStartRow;
+        for (size_t i = pos; i < length; ++i) {
+            state = next[state * NumClasses + byteClass[static_cast<unsigned char>(data[i])]];
+            if (state == LexerTable::kDeadRow) break;
+            if (acceptClass[state] >= 0) {
+                lastEnd = i + 1;
+                lastClass = acceptClass[state];
+            }
+        }
+        tokenClass = lastClass;
+        return lastEnd;
+    }
+
+    /**
+     * 对 input 做词法分析，动作为 Emit 的 token 依次交给 onEmit(offset, length, tokenClass)，
+     * 其余动作的 token 被丢弃（回调与计数由 Lexer::fromTable 得到的 Lexer 处理）
+     * 返回分析停下的位置：等于 input.size() 表示成功，否则为无法识别的字节的偏移
+     */
+    template <typename EmitFn>
+    constexpr size_t forEachToken(std::string_view input, EmitFn&& onEmit) const {
+        size_t pos = 0;
+        while (pos < input.size()) {
+            int tokenClass = -1;
+            size_t end = matchLongest(input.data(), input.size(), pos, tokenClass);
+            if (end == pos) return pos;
+            if (actions[tokenClass] == TokenAction::Emit) onEmit(pos, end - pos, tokenClass);
+            pos = end;
+        }
+        return pos;
+    }
+
+    /**
+     * 以 LexerTable 的形式给出各数组的视图（不持有映像）
+     */
+    LexerTable table() const {
+        LexerTable table;
+        table.byteClass = byteClass;
+        table.numClasses = NumClasses;
+        table.numRows = NumRows;
+        table.numTokenClasses = NumTokenClasses;
+        table.width = static_cast<StateWidth>(sizeof(State));
+        table.nextStates = next;
+        table.acceptClass = acceptClass;
+        table.classAction = actions;
+        table.tokenStartByte = tokenStartByte;
+        return table;
+    }
+};
+
+/**
+ * 在常量求值中为 Rules（constexpr StaticRule 数组）构建 lexer：
+ *     inline constexpr auto kLexer = makeStaticLexer<kRules>();
+ * 容量不足时调大 MaxNfaStates / MaxDfaStates
+ */
+template <const auto& Rules, size_t MaxNfaStates = 512, size_t MaxDfaStates = 256>
+constexpr auto makeStaticLexer() {
+    using namespace static_lexer_detail;
+    constexpr size_t kNumRules = std::extent_v<std::remove_reference_t<decltype(Rules)>>;
+    constexpr Shape kShape = measure<MaxNfaStates, MaxDfaStates>(Rules);
+
+    StaticLexer<kShape.numRows, kShape.numClasses, static_cast<int>(kNumRules)> lexer;
+    SubsetBuilder<MaxNfaStates, MaxDfaStates> builder(Rules);
+    for (int b = 0; b < 256; ++b) lexer.byteClass[b] = builder.byteClass(b);
+
+    // DFA 状态 d 放在第 d + 1 行；-1（死状态）即第 0 行
+    bool startReentered = false;
+    builder.explore([&lexer, &startReentered](int d, int c, int target) {
+        lexer.next[(d + 1) * kShape.numClasses + c] = static_cast<typename decltype(lexer)::State>(target + 1);
+        if (target + 1 == static_cast<int>(LexerTable::kStartRow)) startReentered = true;
+    });
+    lexer.acceptClass[LexerTable::kDeadRow] = -1;
+    for (int d = 0; d < builder.numDfaStates(); ++d) lexer.acceptClass[d + 1] = builder.acceptRule(d);
+    for (size_t r = 0; r < kNumRules; ++r) lexer.actions[r] = Rules[r].action;
+
+    // 与 Lexer::buildTransitionTable 相同的同步字节规则
+    for (int b = 0; b < 256 && !startReentered; ++b) {
+        const int c = lexer.byteClass[b];
+        bool startOnly = lexer.next[LexerTable::kStartRow * kShape.numClasses + c] != LexerTable::kDeadRow;
+        for (int row = LexerTable::kStartRow + 1; startOnly && row < kShape.numRows; ++row) {
+            startOnly = lexer.next[row * kShape.numClasses + c] == LexerTable::kDeadRow;
+        }
+        lexer.tokenStartByte[b] = startOnly;
+    }
+    return lexer;
+}
@@ -0,0 +1,165 @@
+/*
+ * stream_lexer.cpp - implements StreamLexer, the chunked streaming front-end of the lexer.
+ * It features:
+ * - A single growable buffer holding [start of current token, end of data); refills move the
+ * pending bytes to the front and append one chunk, so memory stays at about two chunks
+ * unless one token is larger than that.
+ * - Scanning via advanceMatch over the shared LexerTable, resumed with the saved cursor after
+ * each refill; a token is only cut when the DFA dies or the input ends, which gives exactly
+ * the same longest-match result as tokenizing the whole input at once.
+ * - Line/column tracking over consumed bytes only, so positions cost nothing extra per read.
+ * - Read sources for std::istream and POSIX file descriptors (retrying on EINTR).
+ */
+#include "stream_lexer.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+StreamLexer::StreamLexer(const Lexer& lexer, ReadFn read, size_t chunkSize)
+    : lexer_(lexer), table_(lexer.getTable()), read_(std::move(read)),
+      chunkSize_(std::max<size_t>(chunkSize, 1)) {
+    if (!lexer.isBuilt()) {
+        throw std::runtime_error("Lexer not built. Call build() first.");
+    }
+    buffer_.resize(chunkSize_);
+}
+
+StreamLexer StreamLexer::fromStream(const Lexer& lexer, std::istream& in, size_t chunkSize) {
+    return StreamLexer(lexer, [&in](char* buffer, size_t capacity) -> size_t {
+        in.read(buffer, static_cast<std::streamsize>(capacity));
+        return static_cast<size_t>(in.gcount());
+    }, chunkSize);
+}
+
+StreamLexer StreamLexer::fromFileDescriptor(const Lexer& lexer, int fd, size_t chunkSize) {
+    return StreamLexer(lexer, [fd](char* buffer, size_t capacity) -> size_t {
+        for (;;) {
+#ifdef _WIN32
+            int n = _read(fd, buffer, static_cast<unsigned int>(capacity));
+#else
+            ssize_t n = ::read(fd, buffer, capacity);
+#endif
+            if (n >= 0) return static_cast<size_t>(n);
+            if (errno != EINTR) {
+                throw std::runtime_error(std::string("Read error: ") + std::strerror(errno));
+            }
+        }
+    }, chunkSize);
+}
+
+bool StreamLexer::next(TokenView& token) {
+    switch (table_.width) {
+        case StateWidth::U8:  return nextWithTable<uint8_t>(token);
+        case StateWidth::U16: return nextWithTable<uint16_t>(token);
+        case StateWidth::U32: return nextWithTable<uint32_t>(token);
+    }
+    return false;
+}
+
+template <typename StateT>
+bool StreamLexer::nextWithTable(TokenView& token) {
+    for (;;) {
+        // 1. 缓冲区已扫描完：读入下一块后继续
+        if (scanPos_ == end_ && !eof_) {
+            refill();
+            continue;
+        }
+        if (tokenStart_ == end_) return false;
+
+        // 2. 从上次停下的位置继续推进 DFA；未进入死状态且输入未结束时需要更多数据
+        if (scanPos_ < end_) {
+            scanPos_ = advanceMatch<StateT>(table_, buffer_.data(), scanPos_, end_, cursor_);
+            if (cursor_.state != LexerTable::kDeadRow && !eof_) continue;
+        }
+
+        // 3. 匹配结束：回退到最后一个接受位置
+        if (cursor_.lastAcceptClass < 0) {
+            throwLexicalError();
+        }
+        size_t start = tokenStart_;
+        size_t stop = cursor_.lastAcceptEnd;
+        int tokenClassId = cursor_.lastAcceptClass;
+        int line = line_;
+        int column = column_;
+
+        std::string_view lexeme(buffer_.data() + start, stop - start);
+        advancePosition(start, stop);
+        tokenStart_ = scanPos_ = stop;
+        cursor_ = MatchCursor();
+        cursor_.lastAcceptEnd = stop;
+
+        TokenSpan span = makeTokenSpan(static_cast<size_t>(base_ + start), stop - start, tokenClassId);
+        if (!lexer_.applyTokenAction(span, lexeme)) continue;
+
+        token.lexeme = lexeme;
+        token.offset = base_ + start;
+        token.tokenClassId = tokenClassId;
+        token.line = line;
+        token.column = column;
+        return true;
+    }
+}
+
+bool StreamLexer::refill() {
+    if (eof_) return false;
+
+    // 丢弃当前 token 之前的字节，其余部分（含回退窗口）移到缓冲区开头
+    if (tokenStart_ > 0) {
+        std::copy(buffer_.begin() + tokenStart_, buffer_.begin() + end_, buffer_.begin());
+        base_ += tokenStart_;
+        scanPos_ -= tokenStart_;
+        end_ -= tokenStart_;
+        cursor_.lastAcceptEnd -= tokenStart_;
+        tokenStart_ = 0;
+    }
+    // 只有单个 token 超过一块时缓冲区才会增长
+    if (buffer_.size() - end_ < chunkSize_) {
+        buffer_.resize(end_ + chunkSize_);
+    }
+
+    size_t n = read_(buffer_.data() + end_, chunkSize_);
+    if (n == 0) {
+        eof_ = true;
+        return false;
+    }
+    end_ += n;
+    return true;
+}
+
+void StreamLexer::advancePosition(size_t from, size_t to) {
+    for (size_t i = from; i < to; ++i) {
+        if (buffer_[i] == '\n') {
+            line_++;
+            column_ = 1;
+        } else {
+            column_++;
+        }
+    }
+}
+
+void StreamLexer::throwLexicalError() {
+    // 与整体词法分析保持一致：错误上下文取出错位置起的 20 个字节
+    const size_t contextLength = 20;
+    while (end_ - tokenStart_ < contextLength && refill()) {
+    }
+    size_t length = std::min(contextLength, end_ - tokenStart_);
+    throw std::runtime_error(Lexer::lexicalErrorMessage(
+        line_, column_, std::string_view(buffer_.data() + tokenStart_, length)));
+}
+
+void tokenizeStream(const Lexer& lexer, std::istream& in,
+                    const std::function<void(const TokenView&)>& onToken,
+                    size_t chunkSize) {
+    StreamLexer stream = StreamLexer::fromStream(lexer, in, chunkSize);
+    TokenView token;
+    while (stream.next(token)) {
+        onToken(token);
+    }
+}
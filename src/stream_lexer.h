@@ -0,0 +1,84 @@
+/*
+ * stream_lexer.h - declares StreamLexer, a streaming front-end for a built Lexer that reads
+ * its input in fixed-size chunks from a file descriptor, an std::istream or any read
+ * callback, so files and pipes of any size can be tokenized in bounded memory. It features:
+ * - Resumable scanning: the DFA state and the last accept position (MatchCursor) are kept
+ * across chunk boundaries, so a token split between two reads is continued instead of
+ * being rescanned from its start.
+ * - Bounded buffer: only the bytes from the start of the current token onwards are kept;
+ * they are moved to the front before each refill, which also preserves the longest-match
+ * backtrack window. The buffer grows only when a single token is longer than a chunk.
+ * - Incremental output: 'next' yields one token at a time with a lexeme view into the
+ * buffer, its absolute stream offset and its line/column; 'tokenizeStream' drives it with
+ * a callback.
+ * - Same behaviour as Lexer::tokenize: token actions are applied (skipped classes dropped,
+ * callbacks invoked with absolute offsets) and unrecognized input raises the same error message.
+ */
+#pragma once
+
+#include "lexer.h"
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <istream>
+#include <string_view>
+#include <vector>
+
+class StreamLexer {
+public:
+    // 读取回调：向 buffer 写入至多 capacity 字节，返回实际字节数，0 表示输入结束
+    using ReadFn = std::function<size_t(char* buffer, size_t capacity)>;
+
+    static constexpr size_t kDefaultChunkSize = 64 * 1024;
+
+    StreamLexer(const Lexer& lexer, ReadFn read, size_t chunkSize = kDefaultChunkSize);
+
+    static StreamLexer fromStream(const Lexer& lexer, std::istream& in,
+                                  size_t chunkSize = kDefaultChunkSize);
+    static StreamLexer fromFileDescriptor(const Lexer& lexer, int fd,
+                                          size_t chunkSize = kDefaultChunkSize);
+
+    /**
+     * 取下一个 token，输入结束时返回 false；遇到无法识别的输入时抛出 std::runtime_error
+     * token.lexeme 指向内部缓冲区，在下一次调用 next 之前有效
+     */
+    bool next(TokenView& token);
+
+    // 已从输入读入的总字节数
+    uint64_t bytesRead() const { return base_ + end_; }
+
+private:
+    template <typename StateT>
+    bool nextWithTable(TokenView& token);
+
+    // 把当前 token 之前的字节移出缓冲区并读入下一块，输入已结束时返回 false
+    bool refill();
+
+    // 按已消费的字节推进行列号
+    void advancePosition(size_t from, size_t to);
+
+    [[noreturn]] void throwLexicalError();
+
+    const Lexer& lexer_;
+    const LexerTable& table_;
+    ReadFn read_;
+    size_t chunkSize_;
+
+    std::vector<char> buffer_;
+    uint64_t base_ = 0;       // buffer_[0] 在输入流中的偏移
+    size_t tokenStart_ = 0;   // 当前 token 的起点
+    size_t scanPos_ = 0;      // 下一个待扫描的字节
+    size_t end_ = 0;          // 缓冲区中有效数据的末尾
+    bool eof_ = false;
+
+    MatchCursor cursor_;
+    int line_ = 1;
+    int column_ = 1;
+};
+
+/**
+ * 对整个输入流做词法分析，每个 token 回调一次
+ */
+void tokenizeStream(const Lexer& lexer, std::istream& in,
+                    const std::function<void(const TokenView&)>& onToken,
+                    size_t chunkSize = StreamLexer::kDefaultChunkSize);
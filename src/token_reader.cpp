@@ -0,0 +1,78 @@
+/*
+ * token_reader.cpp - implements TokenReader: on-demand longest-match scanning into a fixed
+ * ring of lookahead tokens. The scan function for the table's state id width is chosen once
+ * in the constructor, so each pulled token costs one indirect call plus the DFA loop.
+ */
+#include "token_reader.h"
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+
+TokenReader::TokenReader(const Lexer& lexer, std::string_view input)
+    : lexer_(lexer), table_(lexer.getTable()), input_(input) {
+    if (!lexer.isBuilt()) {
+        throw std::runtime_error("Lexer not built. Call build() first.");
+    }
+    switch (table_.width) {
+        case StateWidth::U8:  lexOne_ = &TokenReader::lexOne<uint8_t>; break;
+        case StateWidth::U16: lexOne_ = &TokenReader::lexOne<uint16_t>; break;
+        case StateWidth::U32: lexOne_ = &TokenReader::lexOne<uint32_t>; break;
+    }
+}
+
+bool TokenReader::next(TokenView& token) {
+    if (!fill(1)) return false;
+    token = ring_[head_];
+    head_ = (head_ + 1) % kMaxLookahead;
+    --count_;
+    return true;
+}
+
+const TokenView* TokenReader::peek(size_t k) {
+    if (k >= kMaxLookahead) {
+        throw std::out_of_range("TokenReader::peek: lookahead " + std::to_string(k) +
+                                " exceeds " + std::to_string(kMaxLookahead - 1));
+    }
+    if (!fill(k + 1)) return nullptr;
+    return &ring_[(head_ + k) % kMaxLookahead];
+}
+
+bool TokenReader::fill(size_t count) {
+    while (count_ < count) {
+        if (!(this->*lexOne_)()) return false;
+    }
+    return true;
+}
+
+template <typename StateT>
+bool TokenReader::lexOne() {
+    while (pos_ < input_.length()) {
+        int tokenClassId = -1;
+        size_t start = pos_;
+        size_t end = matchLongest<StateT>(table_, input_.data(), input_.length(), start, tokenClassId);
+        if (end == start) {
+            throw std::runtime_error(Lexer::lexicalErrorMessage(
+                line_, column_, input_.substr(start, std::min(size_t(20), input_.length() - start))));
+        }
+
+        int line = line_;
+        int column = column_;
+        for (; pos_ < end; ++pos_) {
+            if (input_[pos_] == '\n') {
+                line_++;
+                column_ = 1;
+            } else {
+                column_++;
+            }
+        }
+        std::string_view lexeme = input_.substr(start, end - start);
+        if (!lexer_.applyTokenAction(makeTokenSpan(start, end - start, tokenClassId), lexeme)) {
+            continue;
+        }
+
+        ring_[(head_ + count_) % kMaxLookahead] = {lexeme, start, tokenClassId, line, column};
+        ++count_;
+        return true;
+    }
+    return false;
+}
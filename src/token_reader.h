@@ -0,0 +1,93 @@
+/*
+ * token_reader.h - declares TokenReader, a pull-based token source over an in-memory input
+ * for parsers that consume tokens one at a time. It features:
+ * - Lazy lexing: a token is scanned only when the caller asks for it with 'next' or 'peek',
+ * so lexing and parsing interleave over the same cache-hot bytes and no token vector is built.
+ * - Bounded lookahead: 'peek(k)' looks up to kMaxLookahead tokens ahead through a small ring
+ * buffer; tokens are views (TokenView) into the caller's input, valid as long as it is.
+ * - Input-range iteration: 'begin'/'end' give a single-pass input iterator, so the reader can
+ * drive a range-for loop or standard algorithms.
+ * - Same results as Lexer::tokenize: token actions are applied, positions count every byte,
+ * and a lexical error is thrown (with the same message) when the bad token is first requested.
+ */
+#pragma once
+
+#include "lexer.h"
+#include <array>
+#include <cstddef>
+#include <iterator>
+#include <string_view>
+
+class TokenReader {
+public:
+    static constexpr size_t kMaxLookahead = 8;
+
+    TokenReader(const Lexer& lexer, std::string_view input);
+
+    /**
+     * 取下一个 token 并前进，输入结束时返回 false
+     */
+    bool next(TokenView& token);
+
+    /**
+     * 查看之后第 k 个 token（k = 0 为下一个）而不前进；不足 k + 1 个 token 时返回 nullptr
+     * k 必须小于 kMaxLookahead；返回的指针在下一次调用 next 之前有效
+     */
+    const TokenView* peek(size_t k = 0);
+
+    bool atEnd() { return peek(0) == nullptr; }
+
+    class iterator {
+    public:
+        using iterator_category = std::input_iterator_tag;
+        using value_type = TokenView;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const TokenView*;
+        using reference = const TokenView&;
+
+        iterator() = default;
+        explicit iterator(TokenReader* reader) : reader_(reader) {
+            if (reader_ && reader_->atEnd()) reader_ = nullptr;
+        }
+
+        reference operator*() const { return *reader_->peek(0); }
+        pointer operator->() const { return reader_->peek(0); }
+
+        iterator& operator++() {
+            TokenView skipped;
+            reader_->next(skipped);
+            if (reader_->atEnd()) reader_ = nullptr;
+            return *this;
+        }
+        void operator++(int) { ++*this; }
+
+        bool operator==(const iterator& other) const { return reader_ == other.reader_; }
+        bool operator!=(const iterator& other) const { return reader_ != other.reader_; }
+
+    private:
+        TokenReader* reader_ = nullptr;   // nullptr 表示已到末尾
+    };
+
+    iterator begin() { return iterator(this); }
+    iterator end() { return iterator(); }
+
+private:
+    // 向预读缓冲区追加一个 token，输入结束时返回 false
+    template <typename StateT>
+    bool lexOne();
+
+    bool fill(size_t count);
+
+    const Lexer& lexer_;
+    const LexerTable& table_;
+    std::string_view input_;
+    bool (TokenReader::*lexOne_)();   // 按状态宽度选定的扫描函数
+
+    size_t pos_ = 0;      // 下一个待扫描的字节
+    int line_ = 1;        // pos_ 处的行列号
+    int column_ = 1;
+
+    std::array<TokenView, kMaxLookahead> ring_;
+    size_t head_ = 0;     // 下一个 token 在 ring_ 中的位置
+    size_t count_ = 0;    // 已预读的 token 数
+};
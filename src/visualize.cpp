@@ -6,7 +6,8 @@
  * - Deterministic output: labels are deduplicated, sorted, and consistently formatted
  * to ensure stable and readable DOT output.
  * - NFA visualization: 'displayNFA' prints NFA transitions to stdout; 'generateDotFile_NFA'
- * exports the NFA to a .dot file with proper start and accept states.
+ * exports the NFA to a .dot file with proper start and accept states. Node names are
+ * derived from node ids on demand via 'nodeDebugName'.
  * - DFA visualization: 'displayDFA' lists DFA states (marking accepting states) and aggregated
  * transitions; 'generateDotFile_DFA' exports the DFA to a .dot file, assuming the first state
  * is initial and marking states that contain the original NFA's final state as accepting.
@@ -25,6 +26,10 @@
 #include <vector>
 #include <algorithm> // for sort
 
+std::string nodeDebugName(int nodeId) {
+    return "q" + std::to_string(nodeId);
+}
+
 std::string getDFAStateName(int id, const std::vector<DFAState>& dfaStates) {
     for(const auto& s : dfaStates) {
         if (s.id == id) return s.stateName;
@@ -57,7 +62,7 @@ std::map<EdgeKey, std::vector<std::string>> aggregateDFAEdges(const std::vector<
 std::map<EdgeKey, std::vector<std::string>> aggregateNFAEdges(const NFAUnit& nfa) {
     std::map<EdgeKey, std::vector<std::string>> aggregated;
     for (const auto& e : nfa.edges) {
-        EdgeKey key{e.startName->id, e.endName->id};
+        EdgeKey key{e.startId, e.endId};
         aggregated[key].push_back(e.symbol.toString());
     }
     return aggregated;
@@ -86,8 +91,8 @@ std::string mergeLabels(const std::vector<std::string>& labels) {
 }
 
 void displayNFA(const NFAUnit& nfa) {
-    std::cout << "NFA States (Start: " << nfa.start->debugName 
-              << ", End: " << nfa.end->debugName << ")\nTransitions:\n";
+    std::cout << "NFA States (Start: " << nodeDebugName(nfa.start) 
+              << ", End: " << nodeDebugName(nfa.end) << ")\nTransitions:\n";
     
     auto aggregated = aggregateNFAEdges(nfa);
     for (const auto& item : aggregated) {
@@ -104,7 +109,7 @@ void displayDFA(const std::vector<DFAState>& dfaStates,
     std::cout << "States:\n";
     for (const auto& state : dfaStates) {
         std::cout << "State " << state.stateName;
-        if (state.nfaStates.count(originalNFAEndId)) std::cout << " [Accepting]";
+        if (state.contains(originalNFAEndId)) std::cout << " [Accepting]";
         std::cout << "\n";
     }
     std::cout << "Transitions:\n";
@@ -121,24 +126,15 @@ void generateDotFile_NFA(const NFAUnit& nfa, const std::string& filename) {
     std::ofstream file(filename);
     if (!file) return;
     file << "digraph NFA { rankdir=LR; node [shape=circle];\n";
-    file << "  " << nfa.end->debugName << " [shape=doublecircle];\n";
-    file << "  __start0 [shape=none, label=\"\"]; __start0 -> " << nfa.start->debugName << ";\n";
+    file << "  " << nodeDebugName(nfa.end) << " [shape=doublecircle];\n";
+    file << "  __start0 [shape=none, label=\"\"]; __start0 -> " << nodeDebugName(nfa.start) << ";\n";
     
     auto aggregated = aggregateNFAEdges(nfa);
-    
-    // 建立 ID 到 Name 的映射，以便在 aggregated map 中查找名字
-    std::map<int, std::string> idToName;
-    idToName[nfa.start->id] = nfa.start->debugName;
-    idToName[nfa.end->id] = nfa.end->debugName;
-    for(const auto& e : nfa.edges) {
-        idToName[e.startName->id] = e.startName->debugName;
-        idToName[e.endName->id] = e.endName->debugName;
-    }
 
     for (const auto& item : aggregated) {
-        // 获取名字，如果找不到（理论上不应发生）则使用 ID
-        std::string startName = idToName.count(item.first.startId) ? idToName[item.first.startId] : ("q" + std::to_string(item.first.startId));
-        std::string endName = idToName.count(item.first.endId) ? idToName[item.first.endId] : ("q" + std::to_string(item.first.endId));
+        // 节点名称按需由 ID 生成
+        std::string startName = nodeDebugName(item.first.startId);
+        std::string endName = nodeDebugName(item.first.endId);
         
         std::string label = mergeLabels(item.second);
         
@@ -164,7 +160,7 @@ void generateDotFile_DFA(const std::vector<DFAState>& dfaStates,
     }
 
     for (const auto& state : dfaStates) {
-        if (state.nfaStates.count(originalNFAEndId))
+        if (state.contains(originalNFAEndId))
             file << "  " << state.stateName << " [shape=doublecircle];\n";
     }
     
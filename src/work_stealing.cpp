@@ -0,0 +1,94 @@
+/*
+ * work_stealing.cpp - implements runWorkStealing with one mutex-protected deque per worker.
+ * Tasks here are coarse (whole files), so a lock per pop/steal costs nothing measurable
+ * next to the task itself, and the victim scan starts at the worker's neighbour to keep
+ * steals spread out.
+ */
+#include "work_stealing.h"
+#include <algorithm>
+#include <deque>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace {
+
+struct WorkerQueue {
+    std::mutex mutex;
+    std::deque<size_t> tasks;
+};
+
+bool popOwn(WorkerQueue& queue, size_t& task) {
+    std::lock_guard<std::mutex> lock(queue.mutex);
+    if (queue.tasks.empty()) return false;
+    task = queue.tasks.front();
+    queue.tasks.pop_front();
+    return true;
+}
+
+bool steal(WorkerQueue& queue, size_t& task) {
+    std::lock_guard<std::mutex> lock(queue.mutex);
+    if (queue.tasks.empty()) return false;
+    task = queue.tasks.back();
+    queue.tasks.pop_back();
+    return true;
+}
+
+} // namespace
+
+unsigned defaultWorkerCount() {
+    return std::max(1u, std::thread::hardware_concurrency());
+}
+
+void runWorkStealing(size_t numTasks, unsigned numWorkers,
+                     const std::function<void(size_t task, unsigned worker)>& fn) {
+    if (numTasks == 0) return;
+    numWorkers = static_cast<unsigned>(std::min<size_t>(std::max(1u, numWorkers), numTasks));
+
+    // 单线程时直接按顺序执行
+    if (numWorkers == 1) {
+        for (size_t task = 0; task < numTasks; ++task) fn(task, 0);
+        return;
+    }
+
+    std::vector<std::unique_ptr<WorkerQueue>> queues;
+    for (unsigned w = 0; w < numWorkers; ++w) {
+        queues.push_back(std::make_unique<WorkerQueue>());
+    }
+    for (size_t task = 0; task < numTasks; ++task) {
+        queues[task % numWorkers]->tasks.push_back(task);
+    }
+
+    std::mutex errorMutex;
+    std::exception_ptr firstError;
+
+    auto work = [&](unsigned worker) {
+        size_t task;
+        for (;;) {
+            bool found = popOwn(*queues[worker], task);
+            for (unsigned k = 1; !found && k < numWorkers; ++k) {
+                found = steal(*queues[(worker + k) % numWorkers], task);
+            }
+            if (!found) return;   // 所有队列都已空
+
+            try {
+                fn(task, worker);
+            } catch (...) {
+                std::lock_guard<std::mutex> lock(errorMutex);
+                if (!firstError) firstError = std::current_exception();
+            }
+        }
+    };
+
+    std::vector<std::thread> threads;
+    threads.reserve(numWorkers - 1);
+    for (unsigned w = 1; w < numWorkers; ++w) {
+        threads.emplace_back(work, w);
+    }
+    work(0);
+    for (auto& t : threads) t.join();
+
+    if (firstError) std::rethrow_exception(firstError);
+}
@@ -0,0 +1,24 @@
+/*
+ * work_stealing.h - declares a small work-stealing scheduler for a fixed set of independent
+ * tasks (e.g. one task per input file). It features:
+ * - Per-worker deques: tasks are dealt round-robin, so low task ids are spread over all
+ * workers and tend to finish first, which keeps in-order consumers of the results busy.
+ * - Each worker takes from the front of its own deque and, once that is empty, steals from
+ * the back of the other workers' deques, balancing uneven task sizes (large files).
+ * - No task is ever added after start, so workers simply exit when every deque is empty.
+ */
+#pragma once
+
+#include <cstddef>
+#include <functional>
+
+/**
+ * 用 numWorkers 个线程执行 task(0) .. task(numTasks - 1)，全部完成后返回
+ * fn 的第二个参数为执行该任务的工作线程编号（0 .. numWorkers - 1），可用于索引线程私有的缓冲区；
+ * 任务抛出的异常会被捕获，并在所有线程结束后由本函数重新抛出第一个
+ */
+void runWorkStealing(size_t numTasks, unsigned numWorkers,
+                     const std::function<void(size_t task, unsigned worker)>& fn);
+
+// 默认工作线程数：硬件并发数（无法获取时为 1）
+unsigned defaultWorkerCount();
@@ -0,0 +1,156 @@
+/*
+ * classified_lexer_test.cpp - checks Lexer::tokenizeSpansClassified against tokenizeSpans
+ * (spans and lexical error messages), once with SimdLevel::None and once with the level the
+ * CPU supports. It covers:
+ * - Random lang.l text with comments and invalid bytes, larger than several classification
+ * windows (ByteClassifier::kBlockSize).
+ * - Tokens longer than a window and tokens that cross a window edge at every offset around it,
+ * including a comment callback that sees the full lexeme.
+ * - Back-up before the window: a scan that reads into a later window and then backs up to a
+ * token end before the current one, both when the rest lexes and when it is an error.
+ * - Unsupported levels: every level, including ones above detectSimdLevel(), can be requested;
+ * the self-loop table and the classifier fall back to a level the CPU has and scan correctly.
+ */
+#include "test_support.h"
+
+namespace {
+
+const char* levelName(SimdLevel level) {
+    switch (level) {
+        case SimdLevel::None: return "none";
+        case SimdLevel::SSE2: return "sse2";
+        case SimdLevel::AVX2: return "avx2";
+    }
+    return "?";
+}
+
+void checkSame(const Lexer& lexer, std::string_view input, const std::string& what) {
+    LexResult expected = lexSpans([&](auto& out) { lexer.tokenizeSpans(input, out); });
+    LexResult actual = lexSpans([&](auto& out) { lexer.tokenizeSpansClassified(input, out); });
+    CHECK(actual == expected, what + ": " + actual.describe() + ", expected " + expected.describe());
+}
+
+void testRandomInputs(Lexer& lang, Lexer& comments, const std::string& level) {
+    std::mt19937 rng(25);
+    int errors = 0;
+    for (int round = 0; round < 200; ++round) {
+        const bool withComments = round % 2 == 1;
+        const Lexer& lexer = withComments ? comments : lang;
+        std::string text = randomSource(rng, 100 + rng() % 20000, withComments, round % 4 == 3 ? 0.0005 : 0);
+        LexResult expected = lexSpans([&](auto& out) { lexer.tokenizeSpans(text, out); });
+        if (!expected.error.empty()) ++errors;
+        checkSame(lexer, text, level + " round " + std::to_string(round));
+    }
+    CHECK(errors > 10, "too few random inputs with lexical errors");
+}
+
+void testLongTokens(const Lexer& lang, const std::string& level, SimdLevel simd) {
+    const size_t block = ByteClassifier::kBlockSize;
+    // 标识符与数字跨过窗口边界：起点在边界前后若干字节
+    for (size_t before : {size_t(0), size_t(1), size_t(7), block - 3, block - 1, block, block + 5}) {
+        for (size_t length : {size_t(1), size_t(2), size_t(15), block, 3 * block + 17}) {
+            std::string text(before, ' ');
+            text += std::string(length, 'a') + " 12.5e+3";
+            checkSame(lang, text, level + " identifier at " + std::to_string(before) + "+" + std::to_string(length));
+            text.back() = '@';
+            checkSame(lang, text, level + " error after identifier at " + std::to_string(before));
+        }
+    }
+
+    // 回调看到的长注释与 tokenizeSpans 相同
+    std::vector<std::string> expected, actual;
+    std::vector<std::string>* sink = &expected;
+    Lexer recording = makeCommentLexer([&sink](const TokenSpan&, std::string_view lexeme) {
+        sink->emplace_back(lexeme);
+    });
+    recording.setSimdLevel(simd);
+    std::string text = "x = 1; #" + std::string(2 * block, 'a') + " b\n" + std::string(block, 'c') + "# y";
+    std::vector<TokenSpan> spans;
+    recording.tokenizeSpans(text, spans);
+    sink = &actual;
+    recording.tokenizeSpansClassified(text, spans);
+    CHECK(actual == expected && expected.size() == 1, level + ": comment callbacks");
+}
+
+void testBackUp(const std::string& level, SimdLevel simd) {
+    // "<"[a-z]*">" 未闭合时退回到 "<"：扫描已读入后面的窗口，下一个 token 却在当前窗口之前
+    Lexer lexer;
+    lexer.addTokenClass("TAG", "\"<\"[a-z]*\">\"");
+    lexer.addTokenClass("LT", "\"<\"");
+    lexer.addTokenClass("WORD", "[a-z]+");
+    lexer.addTokenClass("SPACE", "\" \"", TokenAction::Skip);
+    lexer.build();
+    lexer.setSimdLevel(simd);
+
+    const size_t block = ByteClassifier::kBlockSize;
+    for (size_t before : {size_t(0), size_t(100), block - 2, block - 1, block, block + 1}) {
+        for (size_t body : {block - 50, block, 2 * block + 3}) {
+            std::string prefix(before, ' ');
+            std::string open = prefix + "<" + std::string(body, 'q');
+            checkSame(lexer, open, level + " unclosed tag at " + std::to_string(before) + "+" + std::to_string(body));
+            checkSame(lexer, open + " <ab> z", level + " unclosed tag, then more tokens");
+            checkSame(lexer, open + ">", level + " closed tag");
+            checkSame(lexer, open + "1", level + " unclosed tag, then an error");
+            checkSame(lexer, prefix + "<1" + std::string(body, 'q'), level + " error right after the back-up");
+        }
+    }
+
+    // 注释未闭合：退回到 '#' 报错（lang.l 中没有以 '#' 开头的其他 token）
+    Lexer comments = makeCommentLexer();
+    comments.setSimdLevel(simd);
+    std::string text = "var x = 1;\n#" + std::string(block + 10, 'a') + " b";
+    checkSame(comments, text, level + " unclosed comment");
+}
+
+void testLevelAboveDetected() {
+    const SimdLevel detected = detectSimdLevel();
+    Lexer reference;
+    reference.initializeDefaultTokenClasses();
+    reference.build();
+    reference.setSimdLevel(SimdLevel::None);
+    const std::string text = "var " + std::string(3 * ByteClassifier::kBlockSize, 'a') + " = 1; 123456789012345";
+
+    for (SimdLevel simd : {SimdLevel::None, SimdLevel::SSE2, SimdLevel::AVX2}) {
+        const std::string level = std::string("requested ") + levelName(simd);
+        Lexer lexer = reference;
+        lexer.setSimdLevel(simd);
+        const LexerTable& table = lexer.getTable();
+        if (table.selfLoops) {
+            CHECK(static_cast<int>(table.selfLoops->level) <= static_cast<int>(detected) &&
+                  table.selfLoops->level != SimdLevel::None,
+                  level + ": self loops use " + levelName(table.selfLoops->level));
+        }
+        CHECK(static_cast<int>(table.classifier->level) <= static_cast<int>(detected),
+              level + ": classifier uses " + levelName(table.classifier->level));
+
+        LexResult expected = lexSpans([&](auto& out) { reference.tokenizeSpans(text, out); });
+        LexResult spans = lexSpans([&](auto& out) { lexer.tokenizeSpans(text, out); });
+        LexResult classified = lexSpans([&](auto& out) { lexer.tokenizeSpansClassified(text, out); });
+        CHECK(spans == expected, level + ": tokenizeSpans " + spans.describe());
+        CHECK(classified == expected, level + ": tokenizeSpansClassified " + classified.describe());
+    }
+}
+
+} // namespace
+
+int main() {
+    try {
+        for (SimdLevel simd : {SimdLevel::None, detectSimdLevel()}) {
+            const std::string level = levelName(simd);
+            Lexer lang;
+            lang.initializeDefaultTokenClasses();
+            lang.build();
+            lang.setSimdLevel(simd);
+            Lexer comments = makeCommentLexer();
+            comments.setSimdLevel(simd);
+
+            testRandomInputs(lang, comments, level);
+            testLongTokens(lang, level, simd);
+            testBackUp(level, simd);
+        }
+        testLevelAboveDetected();
+    } catch (const std::exception& e) {
+        CHECK(false, std::string("unexpected exception: ") + e.what());
+    }
+    return testExitCode();
+}
@@ -0,0 +1,89 @@
+/*
+ * default_lexer_test.cpp - checks Lexer::createDefault(), whose table comes from the constexpr
+ * StaticLexer engine (static_lexer.h, a separate regex / NFA / subset construction), against a
+ * Lexer built at run time from initializeDefaultTokenClasses(). Both must give the same spans
+ * and the same lexical error messages through tokenizeSpans. It covers:
+ * - Token classes: the same names and actions in the same order.
+ * - Every single byte and every pair of bytes from a set of interesting ones, so each byte
+ * class and each two-byte operator prefix is reached.
+ * - Random lang.l text with comments and with invalid bytes.
+ * - The compile-time engine itself: kLangLexer.forEachToken emits the same tokens and stops
+ * where the runtime lexer reports its error.
+ */
+#include "lang_lexer.h"
+#include "test_support.h"
+
+namespace {
+
+void checkSame(const Lexer& fromTable, const Lexer& built, std::string_view input, const std::string& what) {
+    LexResult expected = lexSpans([&](auto& out) { built.tokenizeSpans(input, out); });
+    LexResult actual = lexSpans([&](auto& out) { fromTable.tokenizeSpans(input, out); });
+    CHECK(actual == expected, what + ": " + actual.describe() + ", expected " + expected.describe());
+
+    // 编译期引擎：emit 的 token 相同，停止位置即出错位置（无错误时为输入末尾）
+    std::vector<TokenSpan> spans;
+    size_t stop = kLangLexer.forEachToken(input, [&spans](size_t offset, size_t length, int tokenClass) {
+        spans.push_back(makeTokenSpan(offset, length, tokenClass));
+    });
+    if (expected.error.empty()) {
+        CHECK(stop == input.size() && (LexResult{spans, ""}) == expected, what + ": kLangLexer differs");
+    } else {
+        CHECK(stop < input.size(), what + ": kLangLexer accepted input with a lexical error");
+    }
+}
+
+void testTokenClasses(const Lexer& fromTable, const Lexer& built) {
+    const auto& a = fromTable.getTokenClasses();
+    const auto& b = built.getTokenClasses();
+    CHECK(a.size() == b.size(), "token class count");
+    for (size_t i = 0; i < std::min(a.size(), b.size()); ++i) {
+        CHECK(a[i].id == b[i].id && a[i].name == b[i].name && a[i].regex == b[i].regex && a[i].action == b[i].action,
+              "token class " + std::to_string(i) + ": " + a[i].name + " vs " + b[i].name);
+    }
+}
+
+void testShortInputs(const Lexer& fromTable, const Lexer& built) {
+    checkSame(fromTable, built, "", "empty input");
+    for (int b = 0; b < 256; ++b) {
+        checkSame(fromTable, built, std::string(1, static_cast<char>(b)), "byte " + std::to_string(b));
+    }
+    const std::string bytes = "aZ_09.eE+-*/%<>=!&|(){};, \t\r\n@#\x80\xff";
+    for (char x : bytes) {
+        for (char y : bytes) {
+            std::string input{x, y};
+            checkSame(fromTable, built, input, "bytes " + std::to_string(static_cast<unsigned char>(x)) + " " +
+                                                   std::to_string(static_cast<unsigned char>(y)));
+        }
+    }
+}
+
+void testRandomInputs(const Lexer& fromTable, const Lexer& built) {
+    std::mt19937 rng(18);
+    int errors = 0;
+    for (int round = 0; round < 400; ++round) {
+        const double errorRate = round % 3 == 0 ? 0.0 : (round % 3 == 1 ? 0.002 : 0.02);
+        std::string text = randomSource(rng, 50 + rng() % 3000, round % 2 == 1, errorRate);
+        LexResult expected = lexSpans([&](auto& out) { built.tokenizeSpans(text, out); });
+        if (!expected.error.empty()) ++errors;
+        checkSame(fromTable, built, text, "round " + std::to_string(round));
+    }
+    CHECK(errors > 100, "too few random inputs with lexical errors");
+}
+
+} // namespace
+
+int main() {
+    try {
+        const Lexer fromTable = Lexer::createDefault();
+        Lexer built;
+        built.initializeDefaultTokenClasses();
+        built.build();
+
+        testTokenClasses(fromTable, built);
+        testShortInputs(fromTable, built);
+        testRandomInputs(fromTable, built);
+    } catch (const std::exception& e) {
+        CHECK(false, std::string("unexpected exception: ") + e.what());
+    }
+    return testExitCode();
+}
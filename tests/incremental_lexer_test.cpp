@@ -0,0 +1,133 @@
+/*
+ * incremental_lexer_test.cpp - checks Lexer::relexSpans against a fresh tokenizeSpans of the
+ * edited input. It covers:
+ * - Random insertions, deletions and replacements on lang.l text, with and without comments
+ * that contain blanks (so blanks are not token-start bytes), including edits at offset 0 and
+ * at the end of input, applied one after another to the same span list.
+ * - The lookahead case of the file header: rules "a" and "a"*"b" on "aaac" -> "aaab", where a
+ * token ending well before the edit changes.
+ * - Errors: an edit that makes the input unlexable throws the message tokenizeSpans reports
+ * and leaves the span list unchanged.
+ * - Bounded work: one byte inserted near the end of a large comment-lexer input re-lexes only
+ * a few tokens (the backward walk stops at a token-start byte).
+ */
+#include "test_support.h"
+
+namespace {
+
+// 在 text 上执行编辑，然后比较增量结果与完整分析
+void applyAndCheck(const Lexer& lexer, std::string& text, std::vector<TokenSpan>& spans,
+                   size_t offset, size_t removed, const std::string& inserted, const std::string& what) {
+    std::string edited = text;
+    edited.replace(offset, removed, inserted);
+    const TextEdit edit{offset, removed, inserted.size()};
+
+    LexResult expected = lexSpans([&](auto& out) { lexer.tokenizeSpans(edited, out); });
+    std::vector<TokenSpan> before = spans;
+    LexResult actual = lexSpans([&](auto& out) {
+        out = spans;
+        lexer.relexSpans(edited, edit, out);
+        spans = out;
+    });
+    CHECK(actual == expected, what + ": " + actual.describe() + ", expected " + expected.describe());
+    if (!expected.error.empty()) {
+        // 出错时 span 列表必须保持不变，文本也不采用这次编辑
+        LexResult unchanged{spans, ""}, original{before, ""};
+        CHECK(unchanged == original, what + ": spans changed by a failed re-lex");
+        return;
+    }
+    text = std::move(edited);
+}
+
+void testRandomEdits() {
+    const Lexer lang = Lexer::createDefault();
+    const Lexer comments = makeCommentLexer();
+    static const char* const insertions[] = {"", "x", " ", "\n", "#", "# a b #", "1", ".", "e", "+", "=", "==",
+                                             "var y = 2;", "@", "while", "\t", "3.5e+", "# x\n"};
+    std::mt19937 rng(20);
+    int errors = 0;
+    for (int round = 0; round < 200; ++round) {
+        const bool withComments = round % 2 == 1;
+        const Lexer& lexer = withComments ? comments : lang;
+        std::string text = randomSource(rng, 50 + rng() % 800, withComments);
+        std::vector<TokenSpan> spans;
+        lexer.tokenizeSpans(text, spans);
+        for (int step = 0; step < 60; ++step) {
+            size_t offset;
+            switch (rng() % 8) {
+                case 0:  offset = 0; break;
+                case 1:  offset = text.size(); break;
+                default: offset = rng() % (text.size() + 1); break;
+            }
+            size_t removed = std::min<size_t>(text.size() - offset, rng() % 3 == 0 ? rng() % 12 : 0);
+            std::string inserted = insertions[rng() % (sizeof(insertions) / sizeof(insertions[0]))];
+            if (inserted == "@") ++errors;
+            applyAndCheck(lexer, text, spans, offset, removed, inserted,
+                          "round " + std::to_string(round) + " step " + std::to_string(step));
+        }
+    }
+    CHECK(errors > 50, "too few edits on the error path");
+}
+
+void testLookahead() {
+    Lexer lexer;
+    lexer.addTokenClass("A", "\"a\"");
+    lexer.addTokenClass("AB", "\"a\"*\"b\"");
+    lexer.addTokenClass("C", "\"c\"");
+    lexer.build();
+
+    std::string text = "aaac";
+    std::vector<TokenSpan> spans;
+    lexer.tokenizeSpans(text, spans);
+    CHECK(spans.size() == 4, "aaac lexes as a a a c");
+    applyAndCheck(lexer, text, spans, 3, 1, "b", "aaac -> aaab");
+    CHECK(spans.size() == 1 && spans[0].length == 4, "aaab is one AB token");
+    applyAndCheck(lexer, text, spans, 3, 1, "c", "aaab -> aaac");
+    applyAndCheck(lexer, text, spans, 0, 0, "b", "insert at offset 0");
+    applyAndCheck(lexer, text, spans, text.size(), 0, "ab", "append at end");
+    applyAndCheck(lexer, text, spans, text.size() - 1, 1, "", "delete the last byte");
+    applyAndCheck(lexer, text, spans, 0, text.size(), "", "delete everything");
+    applyAndCheck(lexer, text, spans, 0, 0, "aaaaaaab", "insert into empty input");
+}
+
+void testErrorLeavesSpans() {
+    const Lexer lexer = Lexer::createDefault();
+    std::string text = "var x = 1;\nwhile (x < 10) do { x += 1; }\n";
+    std::vector<TokenSpan> spans;
+    lexer.tokenizeSpans(text, spans);
+    const size_t count = spans.size();
+    applyAndCheck(lexer, text, spans, 4, 0, "@", "insert an invalid byte");
+    CHECK(spans.size() == count, "spans after the failed edit");
+    applyAndCheck(lexer, text, spans, text.size(), 0, "$", "append an invalid byte");
+    applyAndCheck(lexer, text, spans, 0, 0, "`", "prepend an invalid byte");
+}
+
+void testBoundedWork() {
+    const Lexer lexer = makeCommentLexer();
+    std::string text;
+    while (text.size() < (1u << 20)) text += "while (counter < limit) do { counter += step; }\n";
+    std::vector<TokenSpan> spans;
+    lexer.tokenizeSpans(text, spans);
+    const size_t offset = text.size() - 100;
+    std::string edited = text;
+    edited.insert(offset, "x");
+    TokenSplice splice = lexer.relexSpans(edited, {offset, 0, 1}, spans);
+    CHECK(splice.removedTokens <= 4 && splice.insertedTokens <= 4,
+          "one-byte insert replaced " + std::to_string(splice.removedTokens) + " tokens");
+    LexResult expected = lexSpans([&](auto& out) { lexer.tokenizeSpans(edited, out); });
+    CHECK((LexResult{spans, ""}) == expected, "spans after the one-byte insert");
+}
+
+} // namespace
+
+int main() {
+    try {
+        testRandomEdits();
+        testLookahead();
+        testErrorLeavesSpans();
+        testBoundedWork();
+    } catch (const std::exception& e) {
+        CHECK(false, std::string("unexpected exception: ") + e.what());
+    }
+    return testExitCode();
+}
@@ -0,0 +1,99 @@
+/*
+ * parallel_lexer_test.cpp - checks Lexer::tokenizeSpansParallel against tokenizeSpans with chunk
+ * sizes small enough that every input is split, so speculation, synchronisation and repair all
+ * run. It covers:
+ * - Random lang.l text with 2-8 threads and 16-512 byte chunks, lexed with the built-in lexer
+ * (blanks are token-start bytes, so chunks usually start on a true token boundary).
+ * - A lexer whose comments may contain blanks and newlines: a chunk that starts inside a
+ * comment speculates from a wrong position, and the stitch must re-lex until it meets the
+ * chunk's tokens again. Callback order must match the sequential scan.
+ * - Errors: an invalid byte in a later chunk reports the same message as the sequential scan,
+ * and a speculative error inside a comment that the true token stream skips over is ignored.
+ */
+#include "test_support.h"
+
+namespace {
+
+void checkSame(const Lexer& lexer, const std::string& input, unsigned threads, size_t chunkSize,
+               const std::string& what) {
+    LexResult sequential = lexSpans([&](auto& out) { lexer.tokenizeSpans(input, out); });
+    LexResult parallel = lexSpans([&](auto& out) { lexer.tokenizeSpansParallel(input, out, threads, chunkSize); });
+    CHECK(parallel == sequential, what + " (threads " + std::to_string(threads) + ", chunk " +
+          std::to_string(chunkSize) + "): " + parallel.describe() + ", expected " + sequential.describe());
+}
+
+void testRandomInputs() {
+    const Lexer lang = Lexer::createDefault();
+    const Lexer comments = makeCommentLexer();
+    std::mt19937 rng(13);
+    const unsigned threads[] = {2, 3, 4, 8};
+    const size_t chunkSizes[] = {16, 61, 128, 512};
+    int errors = 0;
+    for (int round = 0; round < 400; ++round) {
+        const bool withComments = round % 2 == 1;
+        const double errorRate = round % 5 == 0 ? 0.0005 : 0;
+        std::string input = randomSource(rng, 500 + rng() % 6000, withComments, errorRate);
+        LexResult reference = lexSpans([&](auto& out) { (withComments ? comments : lang).tokenizeSpans(input, out); });
+        errors += !reference.error.empty();
+        checkSame(withComments ? comments : lang, input, threads[rng() % 4], chunkSizes[rng() % 4],
+                  "random input " + std::to_string(round));
+    }
+    // 错误路径必须真正被覆盖到
+    CHECK(errors > 10, "too few random inputs with lexical errors: " + std::to_string(errors));
+}
+
+void testChunkInsideComment() {
+    const Lexer lexer = makeCommentLexer();
+    // 块边界落在长注释内部：注释里的空白让推测从 token 中间开始
+    std::string input = "x = 1;\n#";
+    for (int i = 0; i < 200; ++i) input += "a b\nc ";
+    input += "#\ny = 2;\n";
+    for (size_t chunk : {16, 32, 100}) checkSame(lexer, input, 4, chunk, "chunk inside comment");
+
+    // 从注释内部开始的块在推测中会遇到孤立的 '#' 而出错；真实 token 流跨过了该位置，不应报错
+    std::string speculativeError = "a #";
+    for (int i = 0; i < 100; ++i) speculativeError += " x# ";
+    speculativeError.pop_back();
+    speculativeError += "#";
+    checkSame(lexer, speculativeError, 4, 32, "speculative error inside comment");
+}
+
+void testErrorInLaterChunk() {
+    const Lexer lexer = Lexer::createDefault();
+    std::string input;
+    for (int i = 0; i < 300; ++i) input += "var v" + std::to_string(i) + " = " + std::to_string(i) + ";\n";
+    input.insert(input.size() * 3 / 4, "@");
+    LexResult sequential = lexSpans([&](auto& out) { lexer.tokenizeSpans(input, out); });
+    CHECK(!sequential.error.empty(), "input with '@' must fail to lex");
+    for (unsigned threads : {2, 4, 8}) checkSame(lexer, input, threads, 64, "error in later chunk");
+}
+
+void testCallbackOrder() {
+    std::vector<std::string> sequential, parallel;
+    std::vector<std::string>* sink = &sequential;
+    const Lexer lexer = makeCommentLexer([&sink](const TokenSpan&, std::string_view lexeme) {
+        sink->emplace_back(lexeme);
+    });
+
+    std::mt19937 rng(7);
+    std::string input = randomSource(rng, 20000, true);
+    std::vector<TokenSpan> spans;
+    lexer.tokenizeSpans(input, spans);
+    sink = &parallel;
+    lexer.tokenizeSpansParallel(input, spans, 4, 256);
+    CHECK(!sequential.empty() && parallel == sequential, "callbacks differ from the sequential scan");
+}
+
+} // namespace
+
+int main() {
+    try {
+        testRandomInputs();
+        testChunkInsideComment();
+        testErrorInLaterChunk();
+        testCallbackOrder();
+    } catch (const std::exception& e) {
+        CHECK(false, std::string("unexpected exception: ") + e.what());
+    }
+    return testExitCode();
+}
@@ -0,0 +1,254 @@
+#!/usr/bin/env python3
+"""
+自动化测试批处理模式 ./regex_automata lex
+复用 ./lexer_cases/ 中的测试用例：每个用例写成一个输入文件，所有文件在一次调用中完成分析，
+并检查多线程（--jobs）下的输出顺序与单线程一致，以及 compile 生成的映像（--lexer）与现场构建结果一致；
+排在文件之后的标准输入保持命令行顺序；构建缓存（--cache）须在首次构建时写入、之后命中，损坏的缓存项被重建，并发写入者互不干扰；
+compile --stats 输出构建统计
+"""
+import shutil
+import subprocess
+import sys
+import tempfile
+import os
+from pathlib import Path
+
+from test_lexer import LEXER_EXE, PROJECT_ROOT, SCRIPT_DIR, load_test_cases_from_file
+
+
+def unescape(text):
+    """还原 TSV 中转义的词素"""
+    result = []
+    i = 0
+    while i < len(text):
+        if text[i] == "\\" and i + 1 < len(text):
+            result.append({"\\": "\\", "t": "\t", "n": "\n", "r": "\r"}[text[i + 1]])
+            i += 2
+        else:
+            result.append(text[i])
+            i += 1
+    return "".join(result)
+
+
+def run_batch_raw(args, stdin_data=None):
+    """运行 ./regex_automata lex，返回 CompletedProcess"""
+    return subprocess.run(
+        [str(LEXER_EXE), "lex"] + args,
+        input=stdin_data,
+        capture_output=True,
+        text=True,
+        encoding="utf-8",
+        cwd=PROJECT_ROOT,
+        timeout=60,
+    )
+
+
+def run_batch(args, stdin_data=None):
+    """运行 ./regex_automata lex，返回 (退出码, {文件: [(token_type, lexeme)]})"""
+    proc = run_batch_raw(args, stdin_data)
+    records = {}
+    for line in proc.stdout.splitlines():
+        file, _line, _column, token_type, lexeme = line.split("\t")
+        records.setdefault(file, []).append((token_type, unescape(lexeme)))
+    return proc.returncode, records
+
+
+def test_lexer_cases():
+    cases = []
+    for test_file in sorted((SCRIPT_DIR / "lexer_cases").glob("*.txt")):
+        cases.extend(load_test_cases_from_file(test_file))
+
+    passed = 0
+    failed = 0
+    with tempfile.TemporaryDirectory() as tmp:
+        paths = []
+        for i, (input_str, _expected, _source) in enumerate(cases):
+            path = os.path.join(tmp, f"case{i:04d}.src")
+            with open(path, "w", encoding="utf-8") as f:
+                f.write(input_str)
+            paths.append(path)
+
+        returncode, records = run_batch(["--jobs", "1", "--input"] + paths)
+        if returncode not in (0, 1):
+            print(f"❌ 批处理模式异常退出: {returncode}")
+            return 0, len(cases)
+
+        # 多线程时输出（含错误信息）必须与单线程完全一致
+        serial = run_batch_raw(["--jobs", "1", "--input"] + paths)
+        parallel = run_batch_raw(["--jobs", "4", "--input"] + paths)
+        if (serial.stdout, serial.stderr) != (parallel.stdout, parallel.stderr):
+            print("❌ 失败: --jobs 4 的输出与 --jobs 1 不一致")
+            failed += 1
+
+        # 读入已编译的映像后输出必须与现场构建完全一致
+        image = os.path.join(tmp, "lang.lexer")
+        compiled = subprocess.run([str(LEXER_EXE), "compile", "--output", image],
+                                  capture_output=True, cwd=PROJECT_ROOT, timeout=60)
+        loaded = run_batch_raw(["--lexer", image, "--jobs", "1", "--input"] + paths)
+        if compiled.returncode != 0 or (serial.stdout, serial.stderr) != (loaded.stdout, loaded.stderr):
+            print("❌ 失败: --lexer 读入的映像与现场构建的输出不一致")
+            failed += 1
+
+        # 截断的映像必须被拒绝
+        with open(image, "r+b") as f:
+            f.truncate(os.path.getsize(image) // 2)
+        truncated = run_batch_raw(["--lexer", image, "--input"] + paths[:1])
+        if truncated.returncode != 1 or truncated.stdout:
+            print("❌ 失败: 截断的映像未被拒绝")
+            failed += 1
+
+        for path, (input_str, expected, source_file) in zip(paths, cases):
+            actual = records.get(path, [])
+            if actual == expected:
+                passed += 1
+            else:
+                print(f"❌ 失败: {repr(input_str)} (来自 {os.path.basename(source_file)})")
+                print(f"  期望: {expected}")
+                print(f"  实际: {actual}")
+                failed += 1
+    return passed, failed
+
+
+def test_rules_file_and_stdin():
+    with tempfile.TemporaryDirectory() as tmp:
+        rules = os.path.join(tmp, "rules.txt")
+        with open(rules, "w", encoding="utf-8") as f:
+            f.write("# 最长匹配优先，其次按规则顺序；%skip 的类别不输出\n"
+                    "long abc\nshort ab\nSP \" \"|\"\\t\"\n%skip COMMENT \"#\"[a-z]*\n")
+
+        returncode, records = run_batch(["--rules", rules, "--input", "-"], "abc ab#skipped\tabc")
+        expected = [("long", "abc"), ("SP", " "), ("short", "ab"),
+                    ("SP", "\t"), ("long", "abc")]
+        if returncode == 0 and records.get("-") == expected:
+            return 1, 0
+        print("❌ 失败: 规则文件 + 标准输入")
+        print(f"  期望: {expected}")
+        print(f"  实际: {records.get('-')} (退出码 {returncode})")
+        return 0, 1
+
+
+def test_stdin_after_files():
+    # 标准输入排在文件之后：轮到它时才读取，记录仍按命令行顺序；'-' 至多出现一次
+    with tempfile.TemporaryDirectory() as tmp:
+        paths = []
+        for i in range(6):
+            path = os.path.join(tmp, f"file{i}.src")
+            with open(path, "w", encoding="utf-8") as f:
+                f.write(f"x{i} = {i};\n" * 20000)
+            paths.append(path)
+        stdin_data = "while (y < 10) do { y += 1; }\n" * 50000
+        proc = run_batch_raw(["--jobs", "4", "--input"] + paths[:3] + ["-"] + paths[3:], stdin_data)
+        order = []
+        for line in proc.stdout.splitlines():
+            file = line.split("\t", 1)[0]
+            if not order or order[-1] != file:
+                order.append(file)
+        counts = {}
+        for line in proc.stdout.splitlines():
+            file = line.split("\t", 1)[0]
+            counts[file] = counts.get(file, 0) + 1
+        duplicate = run_batch_raw(["--input", "-", paths[0], "-"], "")
+        if (proc.returncode == 0 and order == paths[:3] + ["-"] + paths[3:] and
+                counts["-"] == 50000 * 13 and duplicate.returncode == 2):
+            return 1, 0
+        print(f"❌ 失败: 文件之后的标准输入 (退出码 {proc.returncode}, 顺序 {order}, 重复 '-' 退出码 {duplicate.returncode})")
+        return 0, 1
+
+
+def test_build_cache():
+    passed = 0
+    failed = 0
+    with tempfile.TemporaryDirectory() as tmp:
+        rules = os.path.join(tmp, "rules.txt")
+        with open(rules, "w", encoding="utf-8") as f:
+            f.write("long abc\nshort ab\nAB (\"ab\")*\n%skip SP \" \"|\"\\n\"\n")
+        source = os.path.join(tmp, "input.src")
+        with open(source, "w", encoding="utf-8") as f:
+            f.write("abc ab\nababab abcab")
+        cache = os.path.join(tmp, "cache")
+        args = ["--rules", rules, "--input", source]
+        expected = run_batch_raw(args)
+
+        def cache_files():
+            return sorted(os.listdir(cache)) if os.path.isdir(cache) else []
+
+        # 首次构建写入一个缓存项，再次构建命中且输出不变
+        first = run_batch_raw(["--cache", cache] + args)
+        entries = cache_files()
+        second = run_batch_raw(["--cache", cache] + args)
+        if (len(entries) == 1 and entries == cache_files() and
+                (first.stdout, first.stderr) == (second.stdout, second.stderr) == (expected.stdout, expected.stderr)):
+            passed += 1
+        else:
+            print(f"❌ 失败: 构建缓存未被写入或命中（缓存目录: {cache_files()}）")
+            failed += 1
+
+        # 损坏的缓存项按未命中处理并被重新写入
+        if entries:
+            entry = os.path.join(cache, entries[0])
+            size = os.path.getsize(entry)
+            with open(entry, "r+b") as f:
+                f.truncate(size // 2)
+            repaired = run_batch_raw(["--cache", cache] + args)
+            if (repaired.stdout, repaired.stderr) == (expected.stdout, expected.stderr) and os.path.getsize(entry) == size:
+                passed += 1
+            else:
+                print("❌ 失败: 截断的缓存项未被重建")
+                failed += 1
+
+        # 多个进程同时构建同一规则集：输出一致，只留下一个完整的缓存项
+        shutil.rmtree(cache, ignore_errors=True)
+        processes = [subprocess.Popen([str(LEXER_EXE), "lex", "--cache", cache] + args,
+                                      stdout=subprocess.PIPE, stderr=subprocess.PIPE,
+                                      text=True, encoding="utf-8", cwd=PROJECT_ROOT)
+                     for _ in range(8)]
+        outputs = [p.communicate(timeout=60) for p in processes]
+        if all(out == (expected.stdout, expected.stderr) for out in outputs) and len(cache_files()) == 1:
+            passed += 1
+        else:
+            print(f"❌ 失败: 并发构建的输出或缓存目录不正确（缓存目录: {cache_files()}）")
+            failed += 1
+    return passed, failed
+
+
+def test_build_stats():
+    with tempfile.TemporaryDirectory() as tmp:
+        rules = os.path.join(tmp, "rules.txt")
+        with open(rules, "w", encoding="utf-8") as f:
+            f.write("A \"a\"*\"b\"\nX \"x\"\n")
+        result = subprocess.run([str(LEXER_EXE), "compile", "--rules", rules, "--stats",
+                                 "--output", os.path.join(tmp, "rules.lexer")],
+                                capture_output=True, text=True, cwd=PROJECT_ROOT, timeout=60)
+        stats = dict(line.split(" ", 1) for line in result.stdout.splitlines())
+        # stdout 只有 "名称 值" 行（构建日志不输出），规模与耗时合理
+        try:
+            ok = (result.returncode == 0 and stats["token_classes"] == "2" and
+                  int(stats["nfa_edges"]) > 0 and int(stats["min_dfa_states"]) > 0 and
+                  int(stats["min_dfa_states"]) <= int(stats["dfa_states"]) and
+                  float(stats["total_seconds"]) >= float(stats["subset_seconds"]) >= 0 and
+                  stats["from_cache"] == "0")
+        except (KeyError, ValueError):
+            ok = False
+        if ok:
+            return 1, 0
+        print(f"❌ 失败: compile --stats 的输出不正确: {result.stdout!r}")
+        return 0, 1
+
+
+def main():
+    passed = 0
+    failed = 0
+    for test in (test_lexer_cases, test_rules_file_and_stdin, test_stdin_after_files, test_build_cache,
+                 test_build_stats):
+        p, f = test()
+        passed += p
+        failed += f
+
+    print("\n" + "=" * 60)
+    print(f"✅ 总结: {passed} 通过, {failed} 失败")
+    print("=" * 60)
+    sys.exit(1 if failed > 0 else 0)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,172 @@
+#!/usr/bin/env python3
+"""
+自动化测试扫描器生成 ./regex_automata gen
+对两种代码形态（direct / table）分别生成扫描器，用系统 C++ 编译器（不带本项目头文件）编译一个
+小驱动程序，并检查它对 ./lexer_cases/ 用例的输出（含错误信息）与批处理模式 lex 完全一致
+"""
+import os
+import shutil
+import subprocess
+import sys
+import tempfile
+
+from test_lexer import LEXER_EXE, PROJECT_ROOT, SCRIPT_DIR, load_test_cases_from_file
+from test_batch_lexer import run_batch_raw
+
+# 与 lex 相同的输出格式：file<TAB>line<TAB>column<TAB>class<TAB>lexeme
+DRIVER = r"""
+#include "scanner.h"
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+int main(int argc, char* argv[]) {
+    int status = 0;
+    for (int a = 1; a < argc; ++a) {
+        std::ifstream file(argv[a], std::ios::binary);
+        std::stringstream buffer;
+        buffer << file.rdbuf();
+        std::string input = buffer.str();
+        std::string out;
+        try {
+            NS::Scanner scanner(input);
+            NS::Token token;
+            while (scanner.next(token)) {
+                out += std::string(argv[a]) + "\t" + std::to_string(token.line) + "\t" +
+                       std::to_string(token.column) + "\t" + NS::kTokenClassNames[token.tokenClass] + "\t";
+                for (char c : token.lexeme) {
+                    switch (c) {
+                        case '\\': out += "\\\\"; break;
+                        case '\t': out += "\\t"; break;
+                        case '\n': out += "\\n"; break;
+                        case '\r': out += "\\r"; break;
+                        default: out += c;
+                    }
+                }
+                out += "\n";
+            }
+            std::cout << out;
+        } catch (const std::exception& e) {
+            std::cerr << argv[a] << ": " << e.what() << "\n";
+            status = 1;
+        }
+    }
+    return status;
+}
+"""
+
+
+def build_scanner(tmp, style, gen_args):
+    """生成并编译扫描器，返回可执行文件路径；失败时返回 None"""
+    header = os.path.join(tmp, "scanner.h")
+    gen = subprocess.run([str(LEXER_EXE), "gen", "--style", style, "--namespace", "NS",
+                          "--output", header] + gen_args,
+                         capture_output=True, text=True, cwd=PROJECT_ROOT, timeout=60)
+    if gen.returncode != 0:
+        print(f"❌ gen --style {style} 失败: {gen.stderr}")
+        return None
+
+    driver = os.path.join(tmp, "driver.cpp")
+    with open(driver, "w", encoding="utf-8") as f:
+        f.write(DRIVER)
+    exe = os.path.join(tmp, f"scanner_{style}")
+    compiled = subprocess.run([CXX, "-std=c++17", "-O1", "-Wall", "-Wextra", "-Werror",
+                               "-I", tmp, driver, "-o", exe],
+                              capture_output=True, text=True, timeout=300)
+    if compiled.returncode != 0:
+        print(f"❌ 生成的扫描器（{style}）编译失败:\n{compiled.stderr[:2000]}")
+        return None
+    return exe
+
+
+def compare_with_lex(exe, paths, lex_args, label):
+    """比较生成的扫描器与 lex 的输出，一致时返回 True"""
+    expected = run_batch_raw(lex_args + ["--jobs", "1", "--input"] + paths)
+    actual = subprocess.run([exe] + paths, capture_output=True, text=True, encoding="utf-8",
+                            cwd=PROJECT_ROOT, timeout=60)
+    if (expected.stdout, expected.stderr) == (actual.stdout, actual.stderr):
+        return True
+    print(f"❌ 失败: {label} 与 lex 的输出不一致")
+    for want, got in zip(expected.stdout.splitlines() + expected.stderr.splitlines(),
+                         actual.stdout.splitlines() + actual.stderr.splitlines()):
+        if want != got:
+            print(f"  期望: {want!r}")
+            print(f"  实际: {got!r}")
+            break
+    return False
+
+
+def test_lexer_cases(style):
+    cases = []
+    for test_file in sorted((SCRIPT_DIR / "lexer_cases").glob("*.txt")):
+        cases.extend(load_test_cases_from_file(test_file))
+
+    with tempfile.TemporaryDirectory() as tmp:
+        paths = []
+        for i, (input_str, _expected, _source) in enumerate(cases):
+            path = os.path.join(tmp, f"case{i:04d}.src")
+            with open(path, "w", encoding="utf-8") as f:
+                f.write(input_str)
+            paths.append(path)
+
+        exe = build_scanner(tmp, style, [])
+        if exe and compare_with_lex(exe, paths, [], f"lang.l 规则（{style}）"):
+            return 1, 0
+        return 0, 1
+
+
+RULE_SETS = [
+    # 类别名 long / short 是 C++ 关键字，只能出现在名称表中
+    "long abc\nshort ab\nAB (\"ab\")*\nREP \"x\"(\"ab\")*\"y\"\nSP \" \"|\"\\t\"|\"\\n\"\n"
+    "%skip COMMENT \"#\"[a-z]*\n",
+    # 最小化后初始状态既接受又可被再次进入
+    "AB (\"ab\")*\n%skip SP \" \"\n",
+]
+
+
+def test_rules_file(style):
+    passed = 0
+    failed = 0
+    for n, rule_set in enumerate(RULE_SETS):
+        with tempfile.TemporaryDirectory() as tmp:
+            rules = os.path.join(tmp, "rules.txt")
+            with open(rules, "w", encoding="utf-8") as f:
+                f.write(rule_set)
+            paths = []
+            for i, text in enumerate(["abc ab#skipped\tabc", "xy xaby\nxababy", "ab xa",
+                                      "abcab\n#x abc", "ababab abab"]):
+                path = os.path.join(tmp, f"input{i}.src")
+                with open(path, "w", encoding="utf-8") as f:
+                    f.write(text)
+                paths.append(path)
+
+            exe = build_scanner(tmp, style, ["--rules", rules])
+            if exe and compare_with_lex(exe, paths, ["--rules", rules], f"规则集 {n}（{style}）"):
+                passed += 1
+            else:
+                failed += 1
+    return passed, failed
+
+
+def main():
+    passed = 0
+    failed = 0
+    for style in ("direct", "table"):
+        for test in (test_lexer_cases, test_rules_file):
+            p, f = test(style)
+            passed += p
+            failed += f
+
+    print("\n" + "=" * 60)
+    print(f"✅ 总结: {passed} 通过, {failed} 失败")
+    print("=" * 60)
+    sys.exit(1 if failed > 0 else 0)
+
+
+CXX = os.environ.get("CXX") or shutil.which("c++") or shutil.which("g++")
+
+if __name__ == "__main__":
+    if not CXX:
+        print("未找到 C++ 编译器，跳过")
+        sys.exit(0)
+    main()
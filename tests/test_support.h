@@ -0,0 +1,122 @@
+/*
+ * test_support.h - shared helpers of the C++ API tests (tests/<name>_test.cpp, one ctest test per
+ * file). The Python tests drive the regex_automata binary; these cover the library entry
+ * points the binary does not reach with small inputs. It features:
+ * - CHECK: reports file, line and message on failure and keeps going; main returns
+ * testExitCode(), so one run lists every failing case.
+ * - Reference results: 'lexSpans' runs one span scanner and captures either its spans or its
+ * error message, so every front-end can be compared with tokenizeSpans including errors.
+ * - Inputs: a seeded generator of lang.l text (with optional '#' comments and invalid bytes)
+ * and a lexer with the lang.l rules plus a comment rule whose body may contain blanks, the
+ * lang.l token-start bytes.
+ */
+#pragma once
+
+#include "lexer.h"
+#include <cstdio>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+inline int& testFailures() {
+    static int failures = 0;
+    return failures;
+}
+
+#define CHECK(condition, message)                                                    \
+    do {                                                                             \
+        if (!(condition)) {                                                          \
+            ++testFailures();                                                        \
+            std::fprintf(stderr, "%s:%d: FAILED: %s\n", __FILE__, __LINE__,          \
+                         std::string(message).c_str());                             \
+        }                                                                            \
+    } while (0)
+
+inline int testExitCode() {
+    if (testFailures() > 0) {
+        std::fprintf(stderr, "%d check(s) failed\n", testFailures());
+        return 1;
+    }
+    std::printf("all checks passed\n");
+    return 0;
+}
+
+/**
+ * 一次扫描的结果：成功时为 span 列表，出现词法错误时为错误信息（spans 无意义）
+ */
+struct LexResult {
+    std::vector<TokenSpan> spans;
+    std::string error;
+
+    bool operator==(const LexResult& other) const {
+        if (error != other.error) return false;
+        if (!error.empty()) return true;
+        if (spans.size() != other.spans.size()) return false;
+        for (size_t i = 0; i < spans.size(); ++i) {
+            const TokenSpan& a = spans[i];
+            const TokenSpan& b = other.spans[i];
+            if (a.offset != b.offset || a.length != b.length || a.tokenClassId != b.tokenClassId) return false;
+        }
+        return true;
+    }
+    bool operator!=(const LexResult& other) const { return !(*this == other); }
+
+    std::string describe() const {
+        return error.empty() ? std::to_string(spans.size()) + " spans" : "error '" + error + "'";
+    }
+};
+
+// scan(spans) 为某个扫描入口，例如 [&](auto& out) { lexer.tokenizeSpans(input, out); }
+template <typename ScanFn>
+LexResult lexSpans(ScanFn&& scan) {
+    LexResult result;
+    try {
+        scan(result.spans);
+    } catch (const std::runtime_error& e) {
+        result.error = e.what();
+        result.spans.clear();
+    }
+    return result;
+}
+
+/**
+ * lang.l 规则 + 可跨行、可含空白的注释 COMMENT（#...#）：给出 callback 时交给它，否则丢弃
+ * 空白是 lang.l 的 token 起始字节；注释使空白也能出现在 token 内部
+ */
+inline Lexer makeCommentLexer(TokenCallback callback = nullptr) {
+    Lexer lexer;
+    lexer.initializeDefaultTokenClasses();
+    lexer.addTokenClass("COMMENT", "\"#\"[a-z0-9;=]*((\" \"|\"\\n\")[a-z0-9;=]*)*\"#\"", TokenAction::Skip);
+    if (callback) lexer.setTokenCallback("COMMENT", std::move(callback));
+    lexer.build();
+    return lexer;
+}
+
+/**
+ * 由 rng 生成约 length 字节的 lang.l 源码；comments 为真时混入 #...# 注释，
+ * errorRate > 0 时以该概率插入无法识别的字节，且注释偶尔不闭合
+ */
+inline std::string randomSource(std::mt19937& rng, size_t length, bool comments, double errorRate = 0) {
+    static const char* const pieces[] = {
+        "var", "if", "then", "else", "while", "do", "return", "func", "x", "y1", "_tmp", "counter",
+        "0", "42", "3.14", "1e9", ".5E-3", "8.25e+2", "+", "-", "*", "/", "%", "<", "<=", ">", ">=",
+        "=", "==", "!", "!=", "&", "&&", "||", "+=", "-=", "*=", "/=", "(", ")", "{", "}", ";", ",",
+        " ", " ", "  ", "\t", "\n", "\r\n"};
+    std::uniform_real_distribution<double> unit(0, 1);
+    std::string text;
+    while (text.size() < length) {
+        double roll = unit(rng);
+        if (roll < errorRate) {
+            text += "@$`~"[rng() % 4];
+        } else if (comments && roll < errorRate + 0.05) {
+            text += "#";
+            for (int n = 1 + rng() % 12; n > 0; --n) text += (rng() % 3 == 0) ? "x = 1; " : (rng() % 2 ? " \n" : "a9");
+            if (errorRate == 0 || rng() % 16 != 0) text += "#";    // 允许出错时偶尔不闭合
+        } else {
+            text += pieces[rng() % (sizeof(pieces) / sizeof(pieces[0]))];
+        }
+    }
+    return text;
+}
@@ -0,0 +1,168 @@
+/*
+ * token_reader_test.cpp - checks TokenReader against the span scanners. It covers:
+ * - next(): the pulled tokens (offset, length, class, line, column) equal tokenize and
+ * tokenizeSpans on random lang.l text, Skip and Callback classes included; on bad input the
+ * tokens before the error are those forEachToken emits, then the same message is thrown.
+ * - peek(k): every k below kMaxLookahead at every position, nullptr past the end of input, and
+ * std::out_of_range for k == kMaxLookahead.
+ * - A peek across a bad token throws, and the tokens before it can still be pulled; the error
+ * is thrown again when the bad token is reached.
+ * - The input iterator yields the same tokens as next().
+ */
+#include "test_support.h"
+#include "token_reader.h"
+
+namespace {
+
+struct Expected {
+    std::vector<TokenSpan> spans;   // 错误之前输出的 token
+    std::vector<LexerToken> tokens; // 行列号（无错误时）
+    std::string error;
+};
+
+Expected expectedTokens(const Lexer& lexer, const std::string& input) {
+    Expected expected;
+    try {
+        lexer.forEachToken(input, [&](const TokenSpan& span) { expected.spans.push_back(span); });
+        expected.tokens = lexer.tokenize(input);
+    } catch (const std::runtime_error& e) {
+        expected.error = e.what();
+    }
+    return expected;
+}
+
+bool sameToken(const TokenView& token, const TokenSpan& span, std::string_view input) {
+    return token.offset == span.offset && token.lexeme == Lexer::lexemeOf(input, span) &&
+           token.tokenClassId == span.tokenClassId;
+}
+
+void testNext(const Lexer& lexer, const std::string& input, const std::string& what) {
+    Expected expected = expectedTokens(lexer, input);
+    TokenReader reader(lexer, input);
+    std::string error;
+    size_t count = 0;
+    try {
+        TokenView token;
+        while (reader.next(token)) {
+            bool ok = count < expected.spans.size() && sameToken(token, expected.spans[count], input);
+            if (ok && expected.error.empty()) {
+                ok = token.line == expected.tokens[count].line && token.column == expected.tokens[count].column;
+            }
+            CHECK(ok, what + ": token " + std::to_string(count) + " differs");
+            if (!ok) return;
+            ++count;
+        }
+    } catch (const std::runtime_error& e) {
+        error = e.what();
+    }
+    CHECK(count == expected.spans.size(), what + ": " + std::to_string(count) + " tokens, expected " +
+          std::to_string(expected.spans.size()));
+    CHECK(error == expected.error, what + ": error '" + error + "', expected '" + expected.error + "'");
+}
+
+void testPeek(const Lexer& lexer, const std::string& input, const std::string& what) {
+    Expected expected = expectedTokens(lexer, input);
+    if (!expected.error.empty()) return;
+    const std::vector<TokenSpan>& spans = expected.spans;
+
+    TokenReader reader(lexer, input);
+    for (size_t i = 0; i <= spans.size(); ++i) {
+        for (size_t k = 0; k < TokenReader::kMaxLookahead; ++k) {
+            const TokenView* token = reader.peek(k);
+            bool ok = i + k < spans.size() ? token && sameToken(*token, spans[i + k], input) : token == nullptr;
+            CHECK(ok, what + ": peek(" + std::to_string(k) + ") at token " + std::to_string(i));
+            if (!ok) return;
+        }
+        CHECK(reader.atEnd() == (i == spans.size()), what + ": atEnd at token " + std::to_string(i));
+        TokenView token;
+        CHECK(reader.next(token) == (i < spans.size()), what + ": next at token " + std::to_string(i));
+    }
+
+    bool threw = false;
+    try {
+        reader.peek(TokenReader::kMaxLookahead);
+    } catch (const std::out_of_range&) {
+        threw = true;
+    }
+    CHECK(threw, what + ": peek(kMaxLookahead) must throw std::out_of_range");
+}
+
+void testIterator(const Lexer& lexer, const std::string& input, const std::string& what) {
+    Expected expected = expectedTokens(lexer, input);
+    if (!expected.error.empty()) return;
+    TokenReader reader(lexer, input);
+    size_t count = 0;
+    bool ok = true;
+    for (const TokenView& token : reader) {
+        ok = ok && count < expected.spans.size() && sameToken(token, expected.spans[count], input);
+        ++count;
+    }
+    CHECK(ok && count == expected.spans.size(), what + ": iterator differs from forEachToken");
+}
+
+void testPeekAcrossError() {
+    const Lexer lexer = Lexer::createDefault();
+    const std::string input = "var a = 1;\n b @ c";
+    Expected expected = expectedTokens(lexer, input);   // var a = 1 ; b，然后在 '@' 处出错
+    CHECK(expected.spans.size() == 6 && !expected.error.empty(), "reference for the bad input");
+
+    TokenReader reader(lexer, input);
+    CHECK(reader.peek(5) && reader.peek(5)->lexeme == "b", "peek(5) before the bad token");
+    std::string error;
+    try {
+        reader.peek(6);
+    } catch (const std::runtime_error& e) {
+        error = e.what();
+    }
+    CHECK(error == expected.error, "peek(6) across the bad token: '" + error + "'");
+
+    // 出错之前的 token 仍可取出，到达错误位置时再次抛出同样的错误
+    TokenView token;
+    for (size_t i = 0; i < expected.spans.size(); ++i) {
+        CHECK(reader.next(token) && sameToken(token, expected.spans[i], input), "token " + std::to_string(i) + " after the failed peek");
+    }
+    error.clear();
+    try {
+        reader.next(token);
+    } catch (const std::runtime_error& e) {
+        error = e.what();
+    }
+    CHECK(error == expected.error, "next() at the bad token: '" + error + "'");
+}
+
+void testPeekPastEnd() {
+    const Lexer lexer = Lexer::createDefault();
+    TokenReader reader(lexer, "a  b  ");
+    CHECK(reader.peek(1) && reader.peek(1)->lexeme == "b", "peek(1) on two tokens");
+    CHECK(reader.peek(2) == nullptr && reader.peek(7) == nullptr, "peek past the end of input");
+    CHECK(!reader.atEnd(), "atEnd before the last token");
+
+    TokenReader empty(lexer, "   \n");
+    CHECK(empty.atEnd() && empty.begin() == empty.end(), "input with only skipped tokens");
+}
+
+} // namespace
+
+int main() {
+    try {
+        const Lexer lang = Lexer::createDefault();
+        size_t callbacks = 0;
+        const Lexer comments = makeCommentLexer([&callbacks](const TokenSpan&, std::string_view) { ++callbacks; });
+        std::mt19937 rng(14);
+        for (int round = 0; round < 300; ++round) {
+            const bool withComments = round % 2 == 1;
+            const Lexer& lexer = withComments ? comments : lang;
+            std::string input = randomSource(rng, 1 + rng() % 600, withComments, round % 3 == 0 ? 0.01 : 0);
+            const std::string what = "input " + std::to_string(round);
+            testNext(lexer, input, what);
+            testPeek(lexer, input, what);
+            testIterator(lexer, input, what);
+        }
+        CHECK(callbacks > 0, "no comment callbacks ran");
+        testPeekAcrossError();
+        testPeekPastEnd();
+    } catch (const std::exception& e) {
+        CHECK(false, std::string("unexpected exception: ") + e.what());
+    }
+    return testExitCode();
+}